@@ -0,0 +1,98 @@
+// Battery.c
+// Runs on MSP432
+// Pack voltage on P6.1 (A14), converted by ADC14 once per
+// PWM period on the TIMER_A0 CCR1 output, never polled.
+// The ADC14 ISR is the only writer of everything here.
+// Team Donkey Kong
+
+#include <stdint.h>
+#include "msp.h"
+#include "Priority.h"
+#include "FixedPoint.h"
+#include "Battery.h"
+
+#define TRIGGER  2          // TIMER_A0 count of the conversion, just past the bottom
+#define FILTER   3          // filter time constant 2^3 conversions (160 ms)
+#define FULL_MV  (3300*BATTERY_DIVIDER)  // pack voltage at full scale, AVCC reference
+
+static volatile uint32_t Sum = 0;          // 2^FILTER times the filtered result, 0 none yet
+static volatile uint32_t Millivolts = 0;   // filtered pack voltage
+static volatile q16_t Scale = FX_Q16_ONE;  // duty compensation
+static volatile uint8_t Low = 0;           // 1 while sagging
+
+// ------------Battery_Init------------
+// P6.1 to the ADC, CCR1 toggling once per period as the
+// sample trigger, ADC14 repeating single channel A14 into
+// MEM0 on each rising edge, interrupt on MEM0.
+// Input: none
+// Output: none
+// Assumes: Motor_Init() has started TIMER_A0
+void Battery_Init(void){
+  Sum = Millivolts = 0;
+  Scale = FX_Q16_ONE;
+  Low = 0;
+  P6->SEL0 |= 0x02;
+  P6->SEL1 |= 0x02;                    // P6.1 tertiary function, A14
+  TIMER_A0->CCR[1] = TRIGGER;
+  TIMER_A0->CCTL[1] = 0x0080;          // toggle at TRIGGER on the way up and down: one rising edge per period
+  ADC14->CTL0 &= ~0x00000002;          // ENC off to change the setup
+  ADC14->CTL0 = 0x0C245510;
+  // bits  value
+  // 29-27 001  SHS, TA0_C1 output
+  // 26    1    SHP, sample timer
+  // 21-19 100  SSEL, SMCLK
+  // 18-17 10   CONSEQ, repeat single channel
+  // 15-8  0x55 SHT1 and SHT0, 96 clocks (8 us)
+  // 7     0    MSC, one conversion per trigger edge
+  // 4     1    ON
+  ADC14->CTL1 = 0x00000030;            // 14-bit, start at MEM0
+  ADC14->MCTL[0] = 0x0000008E;         // AVCC/AVSS reference, end of sequence, A14
+  ADC14->IER0 = 0x00000001;            // interrupt on MEM0
+  NVIC_SetPriority(ADC14_IRQn, PRIORITY_BATTERY);
+  NVIC_EnableIRQ(ADC14_IRQn);
+  ADC14->CTL0 |= 0x00000002;           // ENC, wait for the first trigger
+}
+
+// End of a conversion: filter, then update the scale and the
+// low flag. The flag sets on the raw voltage, so a sag during
+// a reversal limits the very next ramp step.
+void ADC14_IRQHandler(void){
+  uint32_t raw = ADC14->MEM[0];        // clears IFG0
+  uint32_t now = raw*FULL_MV/16384, sum = Sum, mv;
+  sum = (sum == 0)? (raw<<FILTER) : (sum - (sum>>FILTER) + raw);
+  Sum = sum;
+  mv = (sum>>FILTER)*FULL_MV/16384;
+  Millivolts = mv;
+  if(mv < BATTERY_PRESENT_MV){
+    Scale = FX_Q16_ONE;                // no pack, the duties are as tuned
+    Low = 0;
+    return;
+  }
+  Scale = FX_Clamp((int32_t)(((uint32_t)BATTERY_NOMINAL_MV<<16)/mv), BATTERY_SCALE_MIN, BATTERY_SCALE_MAX);
+  if(now < BATTERY_LOW_MV){
+    Low = 1;
+  }else if(mv > BATTERY_LOW_MV + BATTERY_HYSTERESIS_MV){
+    Low = 0;
+  }
+}
+
+// ------------Battery_Millivolts------------
+// Input: none
+// Output: filtered pack voltage in mV, 0 before the first conversion
+uint32_t Battery_Millivolts(void){
+  return Millivolts;
+}
+
+// ------------Battery_Scale------------
+// Input: none
+// Output: duty compensation in Q16
+q16_t Battery_Scale(void){
+  return Scale;
+}
+
+// ------------Battery_Low------------
+// Input: none
+// Output: 1 while the pack is sagging, 0 if not
+int Battery_Low(void){
+  return Low;
+}
@@ -0,0 +1,81 @@
+/**
+ * @file      Battery.h
+ * @brief     Battery voltage monitor on ADC14 and the duty compensation it drives
+ * @details   The pack voltage, divided by BATTERY_DIVIDER, is on P6.1
+ * (A14). ADC14 converts it once per PWM period without any software
+ * start: TIMER_A0 CCR1 toggles its output just after the bottom of the
+ * up-down count, while both motor outputs are on, and ADC14 samples on
+ * that rising edge (SHS = TA0_C1), so it sees the voltage under load.
+ * The end of conversion interrupt filters the result and updates:<br>
+ * - the duty scale, BATTERY_NOMINAL_MV over the filtered voltage, that
+ *   TA0_0_IRQHandler applies to every command, so a duty gives the
+ *   same motor voltage as on the pack the FSM_TABLE was tuned on;<br>
+ * - the low flag, set when a single conversion sags below
+ *   BATTERY_LOW_MV and cleared once the filtered voltage is
+ *   BATTERY_HYSTERESIS_MV above it. While it is set the motor ramps
+ *   use at most MOTOR_SLEW_LOW, which limits the current steps of
+ *   hard turns and reversals that could reset the board.<br>
+ * Below BATTERY_PRESENT_MV there is no pack (USB power on the bench):
+ * the scale stays 1.0 and the flag stays clear.
+ * @author    Team Donkey Kong
+ * @note      Battery_Init() after Motor_Init(), which starts TIMER_A0
+ ******************************************************************************/
+
+/*!
+ * @defgroup RSLK_Input_Output
+ * @brief
+ * @{*/
+#ifndef BATTERY_H_
+#define BATTERY_H_
+#include <stdint.h>
+#include "FixedPoint.h"
+
+#ifndef BATTERY_NOMINAL_MV
+#define BATTERY_NOMINAL_MV    8000  // pack voltage the FSM_TABLE duties were tuned at
+#endif
+#define BATTERY_DIVIDER       3     // pack voltage over the voltage at P6.1
+#define BATTERY_LOW_MV        6000  // a conversion below this limits the ramps
+#define BATTERY_HYSTERESIS_MV 300   // filtered voltage above BATTERY_LOW_MV to clear it
+#define BATTERY_PRESENT_MV    3000  // below this no pack is connected
+#define BATTERY_SCALE_MIN FX_Q16(0.8)   // duty scale limits, 10.0 V
+#define BATTERY_SCALE_MAX FX_Q16(1.33)  // and 6.0 V at 8.0 V nominal
+
+/**
+ * Set up P6.1 as A14, ADC14 for 14-bit conversions triggered by
+ * TIMER_A0 CCR1 and the end of conversion interrupt.
+ * @param  none
+ * @return none
+ * @note   Call after Motor_Init(); the first conversion follows within
+ * one PWM period (20 ms)
+ * @brief  Start the battery monitor
+ */
+void Battery_Init(void);
+
+/**
+ * Return the filtered pack voltage.
+ * @param  none
+ * @return voltage in mV, 0 before the first conversion
+ * @brief  Read the battery voltage
+ */
+uint32_t Battery_Millivolts(void);
+
+/**
+ * Return the factor that makes a duty give the same motor voltage as
+ * at BATTERY_NOMINAL_MV.
+ * @param  none
+ * @return duty scale in Q16, BATTERY_SCALE_MIN to BATTERY_SCALE_MAX
+ * @note   Safe to call from any ISR, reads only
+ * @brief  Get the duty compensation
+ */
+q16_t Battery_Scale(void);
+
+/**
+ * Check whether the pack is sagging close to a brown-out.
+ * @param  none
+ * @return 1 while the voltage is low, 0 if not
+ * @note   Safe to call from any ISR, reads only
+ * @brief  Check for a low battery
+ */
+int Battery_Low(void);
+
+#endif /* BATTERY_H_ */
@@ -0,0 +1,335 @@
+// Benchmark.c
+// Runs on MSP432
+// Benchmark firmware: times the sensing, FSM and motor paths
+// and the interrupt entry with the DWT cycle counter, then
+// prints the results over UART0 (eUSCI_A0, P1.3 TX, 460800
+// baud) and repeats once a second.
+// Compiled only when BENCHMARK is defined: build the Benchmark
+// configuration, which defines it and leaves JackiFSMmain.c out.
+// Put the robot on a stand; the motor test lets the driver sleep
+// pins float to their pull-downs, but the IR LEDs flash during
+// the read test.
+//
+// Output, one comma separated line per measurement after a
+// header line with the core clock:
+//   bench,clock,<Hz>
+//   name,arg,count,min,max,avg
+//   overhead,0,...           two back-to-back CYCCNT reads
+//   read,<us>,...            blocking Reflectance_Read(us)
+//   position,256,...         Reflectance_Position over 0..255
+//   fsm,256,...              FSM_Step over 0..255, dwell expired
+//   motor_isr,2,...          TA0_0_IRQHandler body, ramp and latch
+//                            toward two alternating words
+//   isr_pendsv,0,...         PendSV set to first handler statement
+//   isr_systick,0,...        SysTick reload to handler (Scheduler_Latency)
+//   kernel_flash,256,...     control kernel copy run from flash
+//   kernel_ram,256,...       the same kernel as RAMFUNC, from SRAM_CODE
+// min, max and avg are core clock cycles with the overhead
+// taken off, except isr_systick, which SysTick counts itself.
+// The kernel pair is the flash/SRAM saving within one build; to
+// see it on every row, build again with NO_RAMFUNC added to the
+// configuration's symbols and compare the two tables.
+// Team Donkey Kong
+
+#include <stdint.h>
+
+#ifdef BENCHMARK
+#include "msp.h"
+#include "Clock.h"
+#include "CortexM.h"
+#include "Priority.h"
+#include "Ram.h"
+#include "Reflectance.h"
+#include "Motor.h"
+#include "FSM.h"
+#include "Scheduler.h"
+#include "Telemetry.h"
+
+#define REPEAT      32      // samples per read time and of each interrupt
+#define ROUNDS       4      // passes over the 256 inputs
+#define TICKS     1000      // SysTick entries sampled (1 s at 1 kHz)
+
+static const uint32_t ReadTimes[] = {250, 500, 750, 1000, 1500, 2000}; // us
+static const int32_t Weights[8] = {-33400,-23800,-14300,-4800,4800,14300,23800,33400};
+
+/**
+ * \brief Statistics of one measurement
+ */
+struct Bench_Stat {
+  uint32_t count;           // number of samples
+  uint32_t min;             // fewest cycles
+  uint32_t max;             // most cycles
+  uint64_t total;           // sum of cycles, avg = total/count
+};
+typedef struct Bench_Stat Bench_Stat_t;
+
+static uint32_t Overhead;   // cycles of an empty measurement
+static volatile uint32_t Pended;   // CYCCNT when PendSV was set
+static volatile uint32_t Entered;  // CYCCNT in PendSV_Handler, 0 until then
+static volatile uint8_t Sink;      // keeps results the compiler would drop
+static volatile int32_t SinkPosition;
+
+static void Stat_Clear(Bench_Stat_t *s){
+  s->count = 0;
+  s->min = 0xFFFFFFFF;
+  s->max = 0;
+  s->total = 0;
+}
+
+// Add one sample, less the measurement overhead
+static void Stat_Add(Bench_Stat_t *s, uint32_t cycles){
+  cycles = (cycles > Overhead)? (cycles - Overhead) : 0;
+  s->count++;
+  s->total += cycles;
+  if(cycles < s->min) s->min = cycles;
+  if(cycles > s->max) s->max = cycles;
+}
+
+// Send one character, polled; the DMA is never started
+static void OutChar(char c){
+  while((EUSCI_A0->IFG&0x02) == 0){}
+  EUSCI_A0->TXBUF = c;
+}
+
+static void OutString(const char *s){
+  while(*s){
+    OutChar(*s);
+    s++;
+  }
+}
+
+static void OutUDec(uint32_t n){
+  char buf[10];
+  int i = 0;
+  do{
+    buf[i] = '0' + n%10;
+    n = n/10;
+    i++;
+  }while(n);
+  while(i){
+    i--;
+    OutChar(buf[i]);
+  }
+}
+
+// One line of the table: name,arg,count,min,max,avg
+static void Report(const char *name, uint32_t arg, const Bench_Stat_t *s){
+  OutString(name);
+  OutChar(',');
+  OutUDec(arg);
+  OutChar(',');
+  OutUDec(s->count);
+  OutChar(',');
+  OutUDec(s->count? s->min : 0);
+  OutChar(',');
+  OutUDec(s->max);
+  OutChar(',');
+  OutUDec(s->count? (uint32_t)(s->total/s->count) : 0);
+  OutString("\r\n");
+}
+
+// Cost of the measurement itself, the smallest of many
+static void Bench_Overhead(void){
+  Bench_Stat_t s;
+  uint32_t i, start, sr;
+  Overhead = 0;
+  Stat_Clear(&s);
+  for(i = 0; i < 256; i++){
+    sr = StartCritical();
+    start = DWT->CYCCNT;
+    Stat_Add(&s, DWT->CYCCNT - start);
+    EndCritical(sr);
+  }
+  Report("overhead", 0, &s);
+  Overhead = s.min;
+}
+
+// Blocking reads at each sample time
+static void Bench_Read(void){
+  Bench_Stat_t s;
+  uint32_t i, j, start, sr;
+  for(j = 0; j < sizeof(ReadTimes)/sizeof(ReadTimes[0]); j++){
+    Stat_Clear(&s);
+    for(i = 0; i < REPEAT; i++){
+      sr = StartCritical();
+      start = DWT->CYCCNT;
+      Sink = Reflectance_Read(ReadTimes[j]);
+      Stat_Add(&s, DWT->CYCCNT - start);
+      EndCritical(sr);
+    }
+    Report("read", ReadTimes[j], &s);
+  }
+}
+
+// Every possible sensor sample, several rounds
+static void Bench_Position(void){
+  Bench_Stat_t s;
+  uint32_t i, k, start, sr;
+  Stat_Clear(&s);
+  for(k = 0; k < ROUNDS; k++){
+    for(i = 0; i < 256; i++){
+      sr = StartCritical();
+      start = DWT->CYCCNT;
+      SinkPosition = Reflectance_Position((uint8_t)i);
+      Stat_Add(&s, DWT->CYCCNT - start);
+      EndCritical(sr);
+    }
+  }
+  Report("position", 256, &s);
+}
+
+// Every sample with the dwell cleared, so each step classifies
+// the frame and posts it; back to L_Center whenever it stops
+static void Bench_FSM(void){
+  Bench_Stat_t s;
+  FSM_t fsm;
+  uint32_t i, k, start, sr;
+  Stat_Clear(&s);
+  FSM_Init(&fsm, L_Center);
+  for(k = 0; k < ROUNDS; k++){
+    for(i = 0; i < 256; i++){
+      if(fsm.state == Stop){
+        FSM_Enter(&fsm, L_Center);
+      }
+      fsm.dwell = 0;
+      sr = StartCritical();
+      start = DWT->CYCCNT;
+      Sink = FSM_Step(&fsm, (uint8_t)i);
+      Stat_Add(&s, DWT->CYCCNT - start);
+      EndCritical(sr);
+    }
+  }
+  Report("fsm", 256, &s);
+}
+
+void TA0_0_IRQHandler(void);
+
+// The PWM period handler called directly with the CCR0 interrupt
+// masked: battery scale, both ramps and the latch, which every
+// call takes since the words alternate. P3.6/P3.7 are inputs
+// meanwhile, so its wake of the drivers goes nowhere.
+static void Bench_Motor(void){
+  Bench_Stat_t s;
+  uint32_t i, start, sr;
+  Stat_Clear(&s);
+  NVIC_DisableIRQ(TA0_0_IRQn);
+  P3->DIR &= ~0xC0;              // nSLEEP pulled down by the drivers
+  for(i = 0; i < 256; i++){
+    Motor_Command((i&1)? FSM_Output[L_Center] : FSM_Output[H_left]);
+    sr = StartCritical();
+    start = DWT->CYCCNT;
+    TA0_0_IRQHandler();
+    Stat_Add(&s, DWT->CYCCNT - start);
+    EndCritical(sr);
+  }
+  Motor_Stop();
+  P3->DIR |= 0xC0;
+  NVIC_ClearPendingIRQ(TA0_0_IRQn);
+  NVIC_EnableIRQ(TA0_0_IRQn);
+  Report("motor_isr", 2, &s);
+}
+
+// Control kernel without calls, so a copy runs wholly from where
+// it is placed: the mean sensor weight of every sample and its
+// FSM_Far class. Written once, built twice.
+#define KERNEL_BODY { \
+  uint32_t i, b; \
+  int32_t sum, count, acc = 0; \
+  for(i = 0; i < 256; i++){ \
+    sum = count = 0; \
+    for(b = 0; b < 8; b++){ \
+      if(i&(1u<<b)){ \
+        sum += Weights[b]; \
+        count++; \
+      } \
+    } \
+    sum = count? sum/count : 0; \
+    acc += (sum > FSM_Far) - (sum < -FSM_Far); \
+  } \
+  return acc; \
+}
+static int32_t KernelFlash(void) KERNEL_BODY
+RAMFUNC static int32_t KernelRam(void) KERNEL_BODY
+
+static void Bench_Kernel(const char *name, int32_t (*kernel)(void)){
+  Bench_Stat_t s;
+  uint32_t i, start, sr;
+  Stat_Clear(&s);
+  for(i = 0; i < REPEAT; i++){
+    sr = StartCritical();
+    start = DWT->CYCCNT;
+    SinkPosition = kernel();
+    Stat_Add(&s, DWT->CYCCNT - start);
+    EndCritical(sr);
+  }
+  Report(name, 256, &s);
+}
+
+// Entry of an interrupt set from software
+void PendSV_Handler(void){
+  Entered = DWT->CYCCNT;
+}
+
+static void Bench_PendSV(void){
+  Bench_Stat_t s;
+  uint32_t i;
+  Stat_Clear(&s);
+  NVIC_SetPriority(PendSV_IRQn, PRIORITY_BENCH);
+  for(i = 0; i < REPEAT; i++){
+    Entered = 0;
+    Pended = DWT->CYCCNT;
+    SCB->ICSR = SCB_ICSR_PENDSVSET_Msk;
+    while(Entered == 0){}
+    Stat_Add(&s, Entered - Pended);
+  }
+  Report("isr_pendsv", 0, &s);
+}
+
+// Real tick interrupts from an idle loop, measured by the
+// scheduler's own SysTick_Handler, in SysTick (core) cycles
+static void Bench_SysTick(void){
+  Bench_Stat_t s;
+  uint32_t i, tick, keep = Overhead;
+  Stat_Clear(&s);
+  Overhead = 0;
+  Scheduler_Init(1000);
+  Scheduler_Start();
+  tick = Scheduler_Ticks();
+  for(i = 0; i < TICKS; i++){
+    while(Scheduler_Ticks() == tick){}
+    tick = Scheduler_Ticks();
+    Stat_Add(&s, Scheduler_Latency());
+  }
+  SysTick->CTRL = 0;
+  Overhead = keep;
+  Report("isr_systick", 0, &s);
+}
+
+void main(void){
+  Ram_Init();                    // vector table and RAMFUNC code as in the race build
+  Clock_Init48MHz();
+  Motor_Init();
+  Reflectance_Init();
+  Telemetry_Init();              // UART only, no record is ever logged
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CYCCNT = 0;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+  EnableInterrupts();
+  while(1){
+    OutString("bench,clock,");
+    OutUDec(Clock_GetFreq());
+    OutString("\r\nname,arg,count,min,max,avg\r\n");
+    Bench_Overhead();
+    Bench_Read();
+    Bench_Position();
+    Bench_FSM();
+    Bench_Motor();
+    Bench_PendSV();
+    Bench_SysTick();
+    Bench_Kernel("kernel_flash", &KernelFlash);
+    Bench_Kernel("kernel_ram", &KernelRam);
+    OutString("\r\n");
+    Clock_Delay1ms(1000);
+  }
+}
+#endif
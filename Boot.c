@@ -0,0 +1,68 @@
+// Boot.c
+// Runs on MSP432
+// Boot-time trace. Each mark stores CYCCNT and the MCLK rate
+// read back from the clock system, so the trace does not depend
+// on any initialized global and works from Reset_Handler on.
+// Team Donkey Kong
+
+#include <stdint.h>
+#include "msp.h"
+#include "Boot.h"
+
+#pragma NOINIT(BootCycles)
+static uint32_t BootCycles[BOOT_NUM_STAGES];  // CYCCNT at each stage
+#pragma NOINIT(BootKHz)
+static uint32_t BootKHz[BOOT_NUM_STAGES];     // MCLK in kHz at each stage
+#pragma NOINIT(BootMarked)
+static uint32_t BootMarked;                   // bit n set once stage n is marked
+
+// MCLK in kHz from the CS registers (DIVM is /1 in every profile)
+static uint32_t MclkKHz(void){
+  static const uint16_t dco[6] = {1500, 3000, 6000, 12000, 24000, 48000};
+  if((CS->CTL1&0x00000007) == 5){
+    return 48000;                             // HFXT
+  }
+  return dco[((CS->CTL0>>16)&0x07) % 6];      // DCORSEL
+}
+
+// ------------Boot_Mark------------
+// Record the cycle count of a boot stage, once per reset.
+// Input: stage  Boot_Stage that was just reached
+// Output: none
+void Boot_Mark(uint32_t stage){
+  if(stage >= BOOT_NUM_STAGES){
+    return;
+  }
+  if(stage == BOOT_RESET){
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    BootMarked = 0;
+  }
+  if(BootMarked&(1<<stage)){
+    return;
+  }
+  BootCycles[stage] = DWT->CYCCNT;
+  BootKHz[stage] = MclkKHz();
+  BootMarked |= 1<<stage;
+}
+
+// ------------Boot_Micros------------
+// Convert the trace to time since Reset_Handler. Each
+// interval is converted at the MCLK rate in effect at its
+// start, so clock switches must be followed by a mark.
+// Input: stage  Boot_Stage to look up
+// Output: us after Reset_Handler, 0 if not reached
+uint32_t Boot_Micros(uint32_t stage){
+  uint32_t i, last = BOOT_RESET, us = 0;
+  if((stage >= BOOT_NUM_STAGES) || !(BootMarked&(1<<stage))){
+    return 0;
+  }
+  for(i = BOOT_RESET + 1; i <= stage; i++){
+    if(BootMarked&(1<<i)){
+      us += (uint32_t)(((uint64_t)(BootCycles[i] - BootCycles[last])*1000)/BootKHz[last]);
+      last = i;
+    }
+  }
+  return us;
+}
@@ -0,0 +1,57 @@
+/**
+ * @file      Boot.h
+ * @brief     Boot-time trace
+ * @details   Records the DWT cycle counter and the MCLK rate at each
+ * stage of the boot, from the first instruction of Reset_Handler to
+ * the first motor command, so the reset-to-driving time can be read
+ * in the debugger or over telemetry. The trace lives in a NOINIT
+ * section, so the marks taken before the C runtime initialization
+ * survive it. Time spent in the boot ROM before Reset_Handler is not
+ * included.<br>
+ * Each stage is marked once per reset; later marks are ignored.
+ * @author    Team Donkey Kong
+ ******************************************************************************/
+
+/*!
+ * @defgroup MSP432
+ * @brief
+ * @{*/
+#ifndef BOOT_H_
+#define BOOT_H_
+#include <stdint.h>
+
+/**
+ * \brief Boot stages in the order they are reached
+ */
+#define BOOT_STAGES(X) \
+  X(BOOT_RESET)       /* first instruction of Reset_Handler */ \
+  X(BOOT_SYSTEMINIT)  /* WDT held, DCO at 12 MHz */ \
+  X(BOOT_MAIN)        /* C runtime initialized, main() entered */ \
+  X(BOOT_CLOCK)       /* 12 MHz profile set, crystal starting */ \
+  X(BOOT_PERIPH)      /* motors, sensors, bumps, UART initialized on the DCO */ \
+  X(BOOT_HFXT)        /* running at 48 MHz */ \
+  X(BOOT_START)       /* scheduler started */ \
+  X(BOOT_DRIVE)       /* first motor command applied */
+
+#define BOOT_ENUM(name) name,
+enum Boot_Stage { BOOT_STAGES(BOOT_ENUM) BOOT_NUM_STAGES };
+
+/**
+ * Record the time a boot stage was reached. BOOT_RESET also starts
+ * the cycle counter and clears the trace.
+ * @param  stage stage that was just reached
+ * @return none
+ * @note   Safe to call before the C runtime initialization
+ * @brief  Mark a boot stage
+ */
+void Boot_Mark(uint32_t stage);
+
+/**
+ * Return the time a boot stage was reached.
+ * @param  stage stage to look up
+ * @return microseconds after Reset_Handler, 0 if not reached yet
+ * @brief  Read the boot trace
+ */
+uint32_t Boot_Micros(uint32_t stage);
+
+#endif /* BOOT_H_ */
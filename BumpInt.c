@@ -48,6 +48,26 @@ policies, either expressed or implied, of the FreeBSD Project.
 //Josh
 #include <stdint.h>
 #include "msp.h"
+#include "Priority.h"
+#include "Clock.h"
+#include "CortexM.h"
+#include "BumpInt.h"
+#include "Ram.h"
+
+// Event queue, written only by PORT4_IRQHandler and read only by
+// BumpInt_Get(), so Head and Tail each have a single writer.
+static BumpEvent_t Queue[BUMP_QUEUE];
+static volatile uint32_t Head;        // next slot to write, ISR only
+static volatile uint32_t Tail;        // next slot to read, foreground only
+static volatile uint8_t Missed;       // switches that fired while the queue was full
+static volatile uint32_t Overflows;
+static uint8_t Debounce[8];           // ticks left before each P4 pin re-arms
+
+// Pack P4.7-P4.5, P4.3, P4.2 and P4.0 to bits 5-0
+static uint8_t Pack(uint8_t pins){
+    return (pins&0x01) | ((pins&0x0C)>>1) | ((pins&0xE0)>>2);
+}
+
 // Initialize Bump sensors
 // Make six Port 4 pins inputs
 // Activate interface pullup
@@ -55,7 +75,13 @@ policies, either expressed or implied, of the FreeBSD Project.
 // Interrupt on falling edge (on touch)
 
 void BumpInt_Init(void){
-    // write this as part of Lab 14
+    uint32_t i;
+    Head = Tail = 0;
+    Missed = 0;
+    Overflows = 0;
+    for(i = 0; i < 8; i++){
+        Debounce[i] = BUMP_DEBOUNCE;
+    }
     P4->SEL0 &= ~0xED;
     P4->SEL1 &= ~0xED; // GPIO
     P4->DIR &= ~0xED; // make in
@@ -65,8 +91,8 @@ void BumpInt_Init(void){
     P4->IES |= 0xED; // falling edge event
     P4->IFG &= ~0xED; // clear flags
     P4->IE |= 0xED; // arm
-    NVIC->IP[9]=(NVIC->IP[9]&0xFF0FFFFF)|0x00200000; //set interrupt as 1
-    NVIC->ISER[1] = 0x00000040; // interrupt 38
+    NVIC_SetPriority(PORT4_IRQn, PRIORITY_BUMP);
+    NVIC_EnableIRQ(PORT4_IRQn); // interrupt 38
     EnableInterrupts();
 }
 // Read current state of 6 switches
@@ -78,15 +104,86 @@ void BumpInt_Init(void){
 // bit 1 Bump1
 // bit 0 Bump0
 uint8_t Bump_Read(void){
-    // write this as part of Lab 14
-
-    return 0; // replace this line
+    return Pack(~P4->IN&0xED); // negative logic switches
 }
-// we do not care about critical section/race conditions
+
 // triggered on touch, falling edge
-//void PORT4_IRQHandler(void){
-//    // write this as part of Lab 14
-//    P4->IFG &= ~0xED; // clear flags
-//    Motor_Forward(5000, 5000);
-//}
+// Disarm the switches that fired until they are debounced and
+// queue one event for them. Nothing here touches the FSM.
+RAMFUNC void PORT4_IRQHandler(void){
+    uint8_t fired = P4->IFG&P4->IE&0xED;
+    uint32_t head = Head;
+    P4->IFG &= ~fired; // clear flags
+    P4->IE &= ~fired;  // disarm until BumpInt_Tick() re-arms
+    if((head - Tail) >= BUMP_QUEUE){
+        Missed |= Pack(fired);
+        Overflows = Overflows + 1;
+        return;
+    }
+    Queue[head&(BUMP_QUEUE-1)].fired = Pack(fired);
+    Queue[head&(BUMP_QUEUE-1)].state = Bump_Read();
+    Queue[head&(BUMP_QUEUE-1)].time = Clock_Micros();
+    Head = head + 1;
+}
+
+// ------------BumpInt_Tick------------
+// Re-arm each disarmed switch once it has read released
+// for BUMP_DEBOUNCE ticks in a row. IE is written through
+// bit-band so this cannot race the ISR's read-modify-write.
+// Input: none
+// Output: none
+void BumpInt_Tick(void){
+    uint32_t pin;
+    uint8_t disarmed = ~P4->IE&0xED;
+    uint8_t pressed = ~P4->IN&0xED;
+    for(pin = 0; pin < 8; pin++){
+        if(disarmed&(1<<pin)){
+            if(pressed&(1<<pin)){
+                Debounce[pin] = BUMP_DEBOUNCE;   // still touching or bouncing
+            }else if(Debounce[pin] > 1){
+                Debounce[pin]--;
+            }else{
+                Debounce[pin] = BUMP_DEBOUNCE;
+                BITBAND_PERI(P4->IFG, pin) = 0;  // drop edges seen while disarmed
+                BITBAND_PERI(P4->IE, pin) = 1;   // re-arm
+            }
+        }
+    }
+}
 
+// ------------BumpInt_Get------------
+// Take the oldest event from the queue. Switches that
+// overflowed the queue are added to the event taken next.
+// Input: event  receives the event
+// Output: 1 if an event was taken, 0 if none
+int BumpInt_Get(BumpEvent_t *event){
+    uint32_t tail = Tail;
+    uint8_t missed;
+    if(tail == Head){
+        if(Missed == 0){
+            return 0;
+        }
+        event->fired = 0;          // queue drained while events were missed
+        event->state = Bump_Read();
+        event->time = Clock_Micros();
+    }else{
+        *event = Queue[tail&(BUMP_QUEUE-1)];
+        Tail = tail + 1;
+    }
+    if(Missed){
+        uint32_t sr = StartCritical();
+        missed = Missed;
+        Missed = 0;
+        EndCritical(sr);
+        event->fired |= missed;
+    }
+    return 1;
+}
+
+// ------------BumpInt_Overflows------------
+// Return the number of events that found the queue full.
+// Input: none
+// Output: overflow count
+uint32_t BumpInt_Overflows(void){
+    return Overflows;
+}
@@ -62,13 +62,29 @@ policies, either expressed or implied, of the FreeBSD Project.
  * @defgroup RSLK_Input_Output
  * @brief
  * @{*/
+#ifndef BUMPINT_H_
+#define BUMPINT_H_
+#include <stdint.h>
+
+#define BUMP_QUEUE    8     // events held until the control task reads them, power of 2
+#define BUMP_DEBOUNCE 10    // BumpInt_Tick() calls a switch must read released before it re-arms
+
+/**
+ * \brief One collision: which switches fired and when
+ */
+struct BumpEvent {
+  uint8_t fired;        // switches whose falling edge caused the event, Bump_Read() bit order
+  uint8_t state;        // Bump_Read() at the time of the event
+  uint32_t time;        // Clock_Micros() at the time of the event
+};
+typedef struct BumpEvent BumpEvent_t;
 
 /**
  * Initialize Bump sensors<br>
  * Make P4.7-P4.0 as interrupt-driven inputs<br>
  * Activate interface pull-up<br>
  * Interrupt on falling edge
- * @param task user function to run on collision
+ * @param none
  * @return none
  * @brief  Initialize Bump sensors
  */
@@ -89,5 +105,36 @@ void BumpInt_Init(void);
  * @note  result is a packed, right-justified, positive logic
  * @brief  Read current state of 6 switches
  */
-//uint8_t BumpInt_Read(void);
+uint8_t Bump_Read(void);
+
+/**
+ * Debounce the switches. Each switch that fired stays disarmed
+ * until it has read released for BUMP_DEBOUNCE calls in a row, so
+ * contact bounce on press and release produces a single event.
+ * @param none
+ * @return none
+ * @note   Call at a fixed rate, e.g. every 1 ms scheduler tick
+ * @brief  Re-arm debounced switches
+ */
+void BumpInt_Tick(void);
+
+/**
+ * Take the oldest collision event from the queue.
+ * @param event receives the event
+ * @return 1 if an event was taken, 0 if the queue was empty
+ * @note   If the queue was full when a switch fired, the switch is
+ * merged into the fired bits of the next event that is taken, so a
+ * collision is never lost, only its time
+ * @brief  Read a collision event
+ */
+int BumpInt_Get(BumpEvent_t *event);
+
+/**
+ * Return the number of collisions that found the queue full.
+ * @param none
+ * @return overflow count since BumpInt_Init()
+ * @brief  Read the queue overflow counter
+ */
+uint32_t BumpInt_Overflows(void);
 
+#endif /* BUMPINT_H_ */
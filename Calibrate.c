@@ -0,0 +1,125 @@
+// Calibrate.c
+// Runs on MSP432
+// Learns the discharge times of the eight reflectance sensors
+// on the floor and on the line, picks the sample time, and
+// keeps the result in the last flash sector.
+// Team Donkey Kong
+
+#include <stdint.h>
+#include "Reflectance.h"
+#include "Flash.h"
+#include "Calibrate.h"
+
+#define WORDS (sizeof(Calibrate_Profile_t)/4)
+
+static uint16_t Floor[8];   // fastest discharge seen, us
+static uint16_t Line[8];    // slowest discharge seen, us
+
+static const Calibrate_Profile_t Default = {
+  CALIBRATE_MAGIC,
+  {0, 0, 0, 0, 0, 0, 0, 0},
+  {0, 0, 0, 0, 0, 0, 0, 0},
+  1000, 0,                  // the fixed sample time used before calibration
+  1000, 1000,               // and no adaptation without a profile
+  0
+};
+
+// Sum of every word before the checksum, negated
+static uint32_t Checksum(const Calibrate_Profile_t *profile){
+  const uint32_t *p = (const uint32_t *)profile;
+  uint32_t i, sum = 0;
+  for(i = 0; i < WORDS - 1; i++){
+    sum += p[i];
+  }
+  return -sum;
+}
+
+// ------------Calibrate_Load------------
+// Copy the stored profile if its magic and checksum match.
+// Input: profile  receives the stored or the default profile
+// Output: 1 if the stored profile was valid, 0 if not
+int Calibrate_Load(Calibrate_Profile_t *profile){
+  const Calibrate_Profile_t *stored = (const Calibrate_Profile_t *)CALIBRATE_ADDRESS;
+  if((stored->magic == CALIBRATE_MAGIC) && (stored->checksum == Checksum(stored))){
+    *profile = *stored;
+    return 1;
+  }
+  *profile = Default;
+  return 0;
+}
+
+// ------------Calibrate_Save------------
+// Erase the profile sector and program a new profile.
+// Input: profile  profile to store
+// Output: 1 if stored, 0 on a flash error
+int Calibrate_Save(const Calibrate_Profile_t *profile){
+  Calibrate_Profile_t copy = *profile;
+  copy.magic = CALIBRATE_MAGIC;
+  copy.checksum = Checksum(&copy);
+  if(!Flash_Erase(CALIBRATE_ADDRESS)){
+    return 0;
+  }
+  return Flash_Write(CALIBRATE_ADDRESS, (const uint32_t *)&copy, WORDS);
+}
+
+// ------------Calibrate_Begin------------
+// Reset the per-sensor statistics.
+// Input: none
+// Output: none
+void Calibrate_Begin(void){
+  uint32_t i;
+  for(i = 0; i < 8; i++){
+    Floor[i] = CALIBRATE_TIMEOUT;
+    Line[i] = 0;
+  }
+}
+
+// ------------Calibrate_Sample------------
+// Measure all eight discharge times in one charge cycle and
+// widen each sensor's range.
+// Input: none
+// Output: none
+void Calibrate_Sample(void){
+  uint16_t decay[8];
+  uint32_t i;
+  Reflectance_Capture(decay, CALIBRATE_TIMEOUT);
+  for(i = 0; i < 8; i++){
+    if(decay[i] < Floor[i]) Floor[i] = decay[i];
+    if(decay[i] > Line[i]) Line[i] = decay[i];
+  }
+}
+
+// ------------Calibrate_End------------
+// Each sensor's fastest reading is taken as its floor level
+// and its slowest as its line level; the samples themselves
+// are never classified. The window runs from the slowest of
+// the eight floor levels to the fastest of the eight line
+// levels, so it only means something if every sensor crossed
+// both during the sweep, and it says nothing about floor
+// readings slower than a sensor's fastest. The middle of the
+// window has the most margin on both sides.
+// The engine may adapt over the middle half of the window.
+// Input: profile  receives the new profile
+// Output: 1 if the window is at least 2*CALIBRATE_CONTRAST wide
+int Calibrate_End(Calibrate_Profile_t *profile){
+  uint32_t i, floorMax = 0, lineMin = CALIBRATE_TIMEOUT, margin;
+  for(i = 0; i < 8; i++){
+    if(Floor[i] > floorMax) floorMax = Floor[i];
+    if(Line[i] < lineMin) lineMin = Line[i];
+  }
+  if(lineMin < floorMax + 2*CALIBRATE_CONTRAST){
+    return 0;                         // some sensor never saw floor, line, or both
+  }
+  margin = (lineMin - floorMax)/2;
+  for(i = 0; i < 8; i++){
+    profile->floor[i] = Floor[i];
+    profile->line[i] = Line[i];
+  }
+  profile->magic = CALIBRATE_MAGIC;
+  profile->time = floorMax + margin;
+  profile->margin = margin;
+  profile->minTime = floorMax + margin/2;
+  profile->maxTime = lineMin - margin/2;
+  profile->checksum = Checksum(profile);
+  return 1;
+}
@@ -0,0 +1,93 @@
+/**
+ * @file      Calibrate.h
+ * @brief     Reflectance calibration profile, learned on the floor and kept in flash
+ * @details   While the robot sweeps the sensor bar across the line,
+ * Calibrate_Sample() measures the discharge time of every sensor with
+ * Reflectance_Capture(), which is the same as trying every sample time
+ * at once. Each sensor's fastest (floor) and slowest (line) time are
+ * kept, and Calibrate_End() picks the one sample time that is furthest
+ * from all of them, plus the range the acquisition engine may adapt
+ * within. The profile lives in the last flash sector, so later boots
+ * start with it at once.<br>
+ 1) Calibrate_Load() at boot; if it fails (or on request) then<br>
+ 2) Calibrate_Begin(), Calibrate_Sample() every few ms while sweeping<br>
+ 3) Calibrate_End(), and Calibrate_Save() if it returned 1<br>
+ 4) Reflectance_Async_Init() and Reflectance_SetLimits() from the profile<br>
+ * @author    Team Donkey Kong
+ * @note      Call before Reflectance_Async_Init(); Reflectance_Capture()
+ * cannot share the sensors with the acquisition engine
+ ******************************************************************************/
+
+/*!
+ * @defgroup RSLK_Input_Output
+ * @brief
+ * @{*/
+#ifndef CALIBRATE_H_
+#define CALIBRATE_H_
+#include <stdint.h>
+
+#define CALIBRATE_ADDRESS  0x0003F000  // CALIB region in msp432p401r.cmd
+#define CALIBRATE_MAGIC    0x43414C31  // "CAL1", changes with the layout
+#define CALIBRATE_TIMEOUT  2500        // us, longest discharge measured
+#define CALIBRATE_CONTRAST 100         // us, smallest usable margin
+
+/**
+ * \brief One calibration profile, as stored in flash
+ */
+struct Calibrate_Profile {
+  uint32_t magic;          // CALIBRATE_MAGIC
+  uint16_t floor[8];       // fastest discharge of each sensor, us (white floor)
+  uint16_t line[8];        // slowest discharge of each sensor, us (black line)
+  uint16_t time;           // sample time in us, halfway between the worst floor and line
+  uint16_t margin;         // us from time to the nearest floor or line time
+  uint16_t minTime;        // shortest sample time the engine may adapt to
+  uint16_t maxTime;        // longest sample time the engine may adapt to
+  uint32_t checksum;       // -(sum of all words above)
+};
+typedef struct Calibrate_Profile Calibrate_Profile_t;
+
+/**
+ * Read the profile from flash.
+ * @param  profile receives the stored profile, or the default one
+ * @return 1 if a valid profile was found, 0 if the default was used
+ * @note   The default is the old fixed 1000 us sample time
+ * @brief  Load the calibration
+ */
+int Calibrate_Load(Calibrate_Profile_t *profile);
+
+/**
+ * Write a profile to flash, replacing the stored one.
+ * @param  profile profile from Calibrate_End()
+ * @return 1 if written and verified, 0 on a flash error
+ * @note   Blocks for up to about 100 ms
+ * @brief  Store the calibration
+ */
+int Calibrate_Save(const Calibrate_Profile_t *profile);
+
+/**
+ * Clear the per-sensor statistics before a sweep.
+ * @param  none
+ * @return none
+ * @brief  Start a calibration
+ */
+void Calibrate_Begin(void);
+
+/**
+ * Measure all eight discharge times once and update the statistics.
+ * @param  none
+ * @return none
+ * @note   Blocks for up to CALIBRATE_TIMEOUT us
+ * @brief  Take one calibration measurement
+ */
+void Calibrate_Sample(void);
+
+/**
+ * Turn the statistics into a profile.
+ * @param  profile receives the new profile
+ * @return 1 if every sensor saw both floor and line with enough
+ *         contrast, 0 if not (profile is then left unchanged)
+ * @brief  Finish a calibration
+ */
+int Calibrate_End(Calibrate_Profile_t *profile);
+
+#endif /* CALIBRATE_H_ */
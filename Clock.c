@@ -40,59 +40,130 @@ policies, either expressed or implied, of the FreeBSD Project.
 //JOSHUA WAS HERE
 #include <stdint.h>
 #include "msp.h"
+#include "Priority.h"
+#include "CortexM.h"
+#include "Clock.h"
 
-uint32_t ClockFrequency = 3000000; // cycles/second
+uint32_t ClockFrequency = 12000000; // cycles/second, __SYSTEM_CLOCK in system_msp432p401r.c
 //static uint32_t SubsystemFrequency = 3000000; // cycles/second
 
-// ------------Clock_InitFastest------------
-// Configure the system clock to run at the fastest
-// and most accurate settings.  For example, if the
-// LaunchPad has a crystal, it should be used here.
-// Call BSP_Clock_GetFreq() to get the current system
-// clock frequency for the LaunchPad.
-// Input: none
-// Output: none
+// Time base: Timer32 module 1 free-runs from MCLK, counting down
+// through all 32 bits. Elapsed counts are folded into Micros,
+// converted at the MCLK rate in effect when they were counted, so
+// delays and timestamps stay correct across clock changes. The
+// wrap interrupt folds at least once per 2^32 counts (89 s at 48 MHz).
+static uint32_t TicksPerUs = 12;  // Timer32 counts per us, MCLK in MHz
+static uint32_t LastCount;        // Timer32 value at the last fold
+static uint32_t PendingTicks;     // counts not yet converted to us
+static uint32_t Micros;           // us since the time base started
+
+// Start Timer32 module 1, if it is not running yet
+static void Clock_TimerInit(void){
+  if(TIMER32_1->CONTROL&0x00000080){
+    return;                             // already running
+  }
+  TIMER32_1->LOAD = 0xFFFFFFFF;
+  TIMER32_1->CONTROL = 0x000000A2;      // enable, free-running, interrupt, /1, 32-bit
+  LastCount = TIMER32_1->VALUE;
+  PendingTicks = 0;
+  NVIC_SetPriority(T32_INT1_IRQn, PRIORITY_TIMEBASE); // only needs to run every 89 s
+  NVIC_EnableIRQ(T32_INT1_IRQn);
+}
+
+// Fold the counts since the last call into Micros
+// Assumes: interrupts are disabled
+static void Clock_Fold(void){
+  uint32_t now, us;
+  now = TIMER32_1->VALUE;
+  PendingTicks = PendingTicks + (LastCount - now);  // down counter
+  LastCount = now;
+  us = PendingTicks/TicksPerUs;
+  Micros = Micros + us;
+  PendingTicks = PendingTicks - us*TicksPerUs;
+}
+
+// Change the rate used to convert Timer32 counts to us.
+// Call right after MCLK changes.
+// Input: frequency  new MCLK in Hz, a multiple of 1 MHz
+static void Clock_SetTimeBase(uint32_t frequency){
+  uint32_t sr;
+  Clock_TimerInit();
+  sr = StartCritical();
+  Clock_Fold();
+  TicksPerUs = frequency/1000000;
+  EndCritical(sr);
+}
+
 uint32_t Prewait = 0;                   // loops between BSP_Clock_InitFastest() called and PCM idle (expect 0)
 uint32_t CPMwait = 0;                   // loops between Power Active Mode Request and Current Power Mode matching requested mode (expect small)
 uint32_t Postwait = 0;                  // loops between Current Power Mode matching requested mode and PCM module idle (expect about 0)
 uint32_t IFlags = 0;                    // non-zero if transition is invalid
 uint32_t Crystalstable = 0;             // loops before the crystal stabilizes (expect small)
-void Clock_Init48MHz(void){
+
+// One clock profile. SMCLK is 12 MHz in every profile, so the
+// PWM, sensor, encoder and UART timers never need reprogramming.
+struct ClockProfile {
+  uint32_t frequency;                   // MCLK in Hz
+  uint32_t vcore;                       // 0 = AM_LDO_VCORE0, 1 = AM_LDO_VCORE1
+  uint32_t waits;                       // flash wait states
+  uint32_t ctl0;                        // CS CTL0, DCO range (unused for HFXT)
+  uint32_t ctl1;                        // CS CTL1 without the BCLK select
+};
+static const struct ClockProfile Profiles[CLOCK_NUM_PROFILES] = {
+  {48000000, 1, 2, 0x00000000,
+   0x20100255},                         // MCLK HFXT/1, HSMCLK HFXT/2, SMCLK HFXT/4, ACLK REFO
+  {24000000, 0, 1, 0x00040000,          // DCORSEL = 24 MHz
+   0x10000233},                         // MCLK DCO/1, HSMCLK DCO/1, SMCLK DCO/2, ACLK REFO
+  {12000000, 0, 0, 0x00030000,          // DCORSEL = 12 MHz
+   0x00000233}                          // MCLK, HSMCLK, SMCLK DCO/1, ACLK REFO
+};
+static uint32_t Profile = CLOCK_NUM_PROFILES;  // none yet: 12 MHz DCO from SystemInit, VCORE0
+static uint32_t Vcore = 0;
+
+// Move the PCM to active mode LDO VCORE0 or VCORE1
+// (see Figure 7-3 on p344 of datasheet; LDO0 <-> LDO1 is a
+// direct transition). Output: 0 on success, -1 on failure
+static int Clock_SetVcore(uint32_t vcore){
   // wait for the PCMCTL0 and Clock System to be write-able by waiting for Power Control Manager to be idle
+  Prewait = 0;
   while(PCM->CTL1&0x00000100){
-//  while(PCMCTL1&0x00000100){
     Prewait = Prewait + 1;
     if(Prewait >= 100000){
-      return;                           // time out error
+      return -1;                        // time out error
     }
   }
-  // request power active mode LDO VCORE1 to support the 48 MHz frequency
+  // request power active mode LDO VCORE0 or VCORE1
   PCM->CTL0 = (PCM->CTL0&~0xFFFF000F) |     // clear PCMKEY bit field and AMR bit field
-//  PCMCTL0 = (PCMCTL0&~0xFFFF000F) |     // clear PCMKEY bit field and AMR bit field
             0x695A0000 |                // write the proper PCM key to unlock write access
-            0x00000001;                 // request power active mode LDO VCORE1
-  // check if the transition is invalid (see Figure 7-3 on p344 of datasheet)
+            vcore;                      // request power active mode LDO VCOREx
+  // check if the transition is invalid
   if(PCM->IFG&0x00000004){
     IFlags = PCM->IFG;                    // bit 2 set on active mode transition invalid; bits 1-0 are for LPM-related errors; bit 6 is for DC-DC-related error
     PCM->CLRIFG = 0x00000004;             // clear the transition invalid flag
-    // to do: look at CPM bit field in PCMCTL0, figure out what mode you're in, and step through the chart to transition to the mode you want
-    // or be lazy and do nothing; this should work out of reset at least, but it WILL NOT work if Clock_Int32kHz() or Clock_InitLowPower() has been called
-    return;
+    return -1;
   }
-  // wait for the CPM (Current Power Mode) bit field to reflect a change to active mode LDO VCORE1
-  while((PCM->CTL0&0x00003F00) != 0x00000100){
+  // wait for the CPM (Current Power Mode) bit field to reflect the change
+  CPMwait = 0;
+  while((PCM->CTL0&0x00003F00) != (vcore<<8)){
     CPMwait = CPMwait + 1;
     if(CPMwait >= 500000){
-      return;                           // time out error
+      return -1;                        // time out error
     }
   }
   // wait for the PCMCTL0 and Clock System to be write-able by waiting for Power Control Manager to be idle
+  Postwait = 0;
   while(PCM->CTL1&0x00000100){
     Postwait = Postwait + 1;
     if(Postwait >= 100000){
-      return;                           // time out error
+      return -1;                        // time out error
     }
   }
+  Vcore = vcore;
+  return 0;
+}
+
+// Start the 48 MHz crystal without waiting for it
+static void Clock_StartCrystal(void){
   // initialize PJ.3 and PJ.2 and make them HFXT (PJ.3 built-in 48 MHz crystal out; PJ.2 built-in 48 MHz crystal in)
   PJ->SEL0 |= 0x0C;
   PJ->SEL1 &= ~0x0C;                    // configure built-in 48 MHz crystal for HFXT operation
@@ -104,25 +175,114 @@ void Clock_Init48MHz(void){
            0x00010000 |                 // HFXT oscillator drive selection for crystals >4 MHz
            0x01000000;                  // enable HFXT
   CS->CTL2 &= ~0x02000000;              // disable high-frequency crystal bypass
+  // CS stays unlocked: CLRIFG is key protected too, and
+  // Clock_StartHFXT() clears HFXTIFG before locking it again
+}
+
+// Start the 48 MHz crystal if needed and wait for it to stabilize.
+// Output: 0 on success, -1 on time out
+static int Clock_StartHFXT(void){
+  if(!(CS->CTL2&0x01000000)){
+    Clock_StartCrystal();
+  }
   // wait for the HFXT clock to stabilize
+  CS->KEY = 0x695A;                     // CLRIFG ignores writes while CS is locked
+  Crystalstable = 0;
   while(CS->IFG&0x00000002){
     CS->CLRIFG = 0x00000002;              // clear the HFXT oscillator interrupt flag
     Crystalstable = Crystalstable + 1;
     if(Crystalstable > 100000){
-      return;                           // time out error
+      CS->KEY = 0;
+      return -1;                        // time out error
+    }
+  }
+  CS->KEY = 0;
+  return 0;
+}
+
+// Set the flash read wait states of both banks
+static void Clock_FlashWaits(uint32_t waits){
+  FLCTL->BANK0_RDCTL = (FLCTL->BANK0_RDCTL&~0x0000F000)|(waits<<12);
+  FLCTL->BANK1_RDCTL = (FLCTL->BANK1_RDCTL&~0x0000F000)|(waits<<12);
+}
+
+// ------------Clock_SetProfile------------
+// Switch MCLK to one of the clock profiles. Going up, the
+// core voltage and flash wait states are raised before the
+// clock; going down, they are lowered after it. SMCLK stays
+// at 12 MHz. The HFXT is stopped in the DCO profiles.
+// Input: profile  CLOCK_48MHZ, CLOCK_24MHZ or CLOCK_12MHZ
+// Output: 0 on success, -1 if the PCM or the crystal failed
+// (the clock is left at the old profile)
+int Clock_SetProfile(uint32_t profile){
+  const struct ClockProfile *p;
+  if(profile >= CLOCK_NUM_PROFILES){
+    return -1;
+  }
+  if(profile == Profile){
+    return 0;
+  }
+  p = &Profiles[profile];
+  if(p->frequency > ClockFrequency){
+    if((p->vcore > Vcore) && Clock_SetVcore(p->vcore)){
+      return -1;
     }
+    Clock_FlashWaits(p->waits);
+  }
+  if((profile == CLOCK_48MHZ) && Clock_StartHFXT()){
+    return -1;
+  }
+  CS->KEY = 0x695A;                     // unlock CS module for register access
+  if(profile != CLOCK_48MHZ){
+    CS->CTL0 = p->ctl0;                 // DCO range, settles before MCLK moves to it
+  }
+  CS->CTL1 = p->ctl1 | (CS->CTL1&0x00001000);  // keep the BCLK source
+  if(profile != CLOCK_48MHZ){
+    CS->CTL2 &= ~0x01000000;            // stop the HFXT
   }
-  // configure for 2 wait states (minimum for 48 MHz operation) for flash Bank 0
-  FLCTL->BANK0_RDCTL = (FLCTL->BANK0_RDCTL&~0x0000F000)|FLCTL_BANK0_RDCTL_WAIT_2;
-  // configure for 2 wait states (minimum for 48 MHz operation) for flash Bank 1
-  FLCTL->BANK1_RDCTL = (FLCTL->BANK1_RDCTL&~0x0000F000)|FLCTL_BANK1_RDCTL_WAIT_2;
-  CS->CTL1 = 0x20000000 |               // configure for SMCLK divider /4
-           0x00100000 |                 // configure for HSMCLK divider /2
-           0x00000200 |                 // configure for ACLK sourced from REFOCLK
-           0x00000050 |                 // configure for SMCLK and HSMCLK sourced from HFXTCLK
-           0x00000005;                  // configure for MCLK sourced from HFXTCLK
   CS->KEY = 0;                          // lock CS module from unintended access
-  ClockFrequency = 48000000;
+  Clock_SetTimeBase(p->frequency);
+  if(p->frequency < ClockFrequency){
+    Clock_FlashWaits(p->waits);
+    if(p->vcore < Vcore){
+      Clock_SetVcore(p->vcore);         // a failure here only costs power
+    }
+  }
+  ClockFrequency = p->frequency;
+  Profile = profile;
+  return 0;
+}
+
+// ------------Clock_Begin48MHz------------
+// First half of the boot clock setup: run from the 12 MHz
+// DCO profile (SMCLK already at its final 12 MHz) and start
+// the crystal, then return at once so peripherals can be
+// initialized while it stabilizes.
+// Input: none
+// Output: none
+void Clock_Begin48MHz(void){
+  Clock_TimerInit();
+  Clock_SetProfile(CLOCK_12MHZ);
+  Clock_StartCrystal();
+}
+
+// ------------Clock_Finish48MHz------------
+// Second half: raise VCORE, wait for the crystal if it is
+// still settling and switch MCLK to it.
+// Input: none
+// Output: 0 on success, -1 if still on the DCO
+int Clock_Finish48MHz(void){
+  return Clock_SetProfile(CLOCK_48MHZ);
+}
+
+// ------------Clock_Init48MHz------------
+// Switch to the 48 MHz HFXT profile. Also starts the
+// Clock_Micros() time base.
+// Input: none
+// Output: none
+void Clock_Init48MHz(void){
+  Clock_Begin48MHz();
+  Clock_Finish48MHz();
 //  SubsystemFrequency = 12000000;
 }
 
@@ -145,26 +305,48 @@ void delay(unsigned long ulCount){
       "    bne    pdloop\n");
 }
 
+// ------------Clock_Micros------------
+// Monotonic time base in microseconds, independent of
+// the clock frequency and optimization level.
+// Inputs: none
+// Outputs: us since the time base started (wraps after 71 minutes)
+uint32_t Clock_Micros(void){
+  uint32_t sr;
+  uint32_t us;
+  Clock_TimerInit();
+  sr = StartCritical();
+  Clock_Fold();
+  us = Micros;
+  EndCritical(sr);
+  return us;
+}
+
+// Timer32 reached zero; fold so PendingTicks cannot overflow
+void T32_INT1_IRQHandler(void){
+  TIMER32_1->INTCLR = 0;                // acknowledge
+  Clock_Micros();
+}
+
 // ------------Clock_Delay1us------------
-// Simple delay function which delays about n microseconds.
-// Inputs: n, number of us to wait
+// Delay n microseconds using the Timer32 time base.
+// Inputs: n, number of us to wait (n*MHz must be < 2^32)
 // Outputs: none
 void Clock_Delay1us(uint32_t n){
-  n = (382*n)/100;; // 1 us, tuned at 48 MHz
-  while(n){
-    n--;
+  uint32_t start, ticks;
+  Clock_TimerInit();
+  ticks = n*TicksPerUs;
+  start = TIMER32_1->VALUE;
+  while((start - TIMER32_1->VALUE) < ticks){
   }
 }
 
 // ------------Clock_Delay1ms------------
-// Simple delay function which delays about n milliseconds.
+// Delay n milliseconds using the Timer32 time base.
 // Inputs: n, number of msec to wait
 // Outputs: none
 void Clock_Delay1ms(uint32_t n){
   while(n){
-    delay(ClockFrequency/9162);   // 1 msec, tuned at 48 MHz
+    Clock_Delay1us(1000);
     n--;
   }
 }
-
-
@@ -1,7 +1,8 @@
 /**
  * @file      Clock.h
  * @brief     Provide functions that initialize the MSP432 clock module
- * @details   Reconfigure MSP432 to run at 48 MHz
+ * @details   Reconfigure MSP432 to run at 48 MHz, or switch between
+ * the 48, 24 and 12 MHz profiles at runtime
  * @version   TI-RSLK MAX v1.1
  * @author    Daniel Valvano and Jonathan Valvano
  * @copyright Copyright 2019 by Jonathan W. Valvano, valvano@mail.utexas.edu,
@@ -49,22 +50,63 @@ policies, either expressed or implied, of the FreeBSD Project.
  * @defgroup MSP432
  * @brief
  * @{*/
+
+#define CLOCK_48MHZ 0       // HFXT, AM_LDO_VCORE1, 2 flash wait states
+#define CLOCK_24MHZ 1       // DCO, AM_LDO_VCORE0, 1 flash wait state
+#define CLOCK_12MHZ 2       // DCO, AM_LDO_VCORE0, 0 flash wait states
+#define CLOCK_NUM_PROFILES 3
+
 /**
  * Configure the MSP432 clock to run at 48 MHz
  * @param none
  * @return none
  * @note  Since the crystal is used, the bus clock will be very accurate
- * @see Clock_GetFreq()
+ * @see Clock_GetFreq(), Clock_SetProfile()
  * @brief  Initialize clock to 48 MHz
  */
 void Clock_Init48MHz(void);
+
+/**
+ * Start the boot clock setup without waiting: switch to the 12 MHz DCO
+ * profile (SMCLK 12 MHz, as in every profile) and start the crystal.
+ * Peripherals initialized after this keep their timing at 48 MHz.
+ * @param none
+ * @return none
+ * @see Clock_Finish48MHz()
+ * @brief  Start the 48 MHz switch
+ */
+void Clock_Begin48MHz(void);
+
+/**
+ * Finish the boot clock setup started by Clock_Begin48MHz(): raise
+ * VCORE, wait for the crystal if it has not settled, switch to it.
+ * @param none
+ * @return 0 on success, -1 if the clock stayed at 12 MHz
+ * @brief  Finish the 48 MHz switch
+ */
+int Clock_Finish48MHz(void);
+
+/**
+ * Switch MCLK to a clock profile at runtime. The core voltage and flash
+ * wait states follow the PCM transition rules: raised before a faster
+ * clock, lowered after a slower one. SMCLK is 12 MHz in every profile,
+ * so TIMER_A0 (PWM), TIMER_A1, TIMER_A3 and the UART keep their rates;
+ * only MCLK users change. The Clock_Micros() time base is updated here;
+ * call Scheduler_Retime() afterwards to keep the tick rate.
+ * @param profile CLOCK_48MHZ, CLOCK_24MHZ or CLOCK_12MHZ
+ * @return 0 on success, -1 if the transition failed and the old profile is kept
+ * @note  SysTick and DWT cycle counts scale with MCLK
+ * @see Clock_GetFreq()
+ * @brief  Change the clock profile
+ */
+int Clock_SetProfile(uint32_t profile);
  
 
 /**
  * Return the current bus clock frequency
  * @param none
  * @return frequency of the system clock in Hz
- * @note  In this module, the return result will be 3000000 or 48000000
+ * @note  12000000 out of SystemInit, then 48000000, 24000000 or 12000000
  * @see Clock_Init48MHz()
  * @brief Returns current clock bus frequency in Hz
  */
@@ -72,32 +114,39 @@ uint32_t Clock_GetFreq(void);
 
 
 /**
- * Simple delay function which delays about n milliseconds.
- * It is implemented with a nested for-loop and is very approximate.
+ * Delay function which delays n milliseconds.
+ * It is timed by the free-running Timer32 module 1, so it is accurate
+ * at any bus clock that is a multiple of 1 MHz and does not depend on
+ * the optimization level or flash wait states.
  * @param  n is the number of msec to wait
  * @return none
- * @note This function assumes a 48 MHz clock.
- * This implementation is not very accurate.
- * To improve accuracy, you could tune this function
- * by adjusting the constant within the implementation
- * found in the <b>Clock.c</b> file.
- * For a more accurate time delay, you could use the SysTick module.
- * @brief  Software implementation of a busy-wait delay
+ * @note Busy-waits; use the scheduler for anything longer than a few us
+ * @see Clock_Micros()
+ * @brief  Hardware timed busy-wait delay
  */
 void Clock_Delay1ms(uint32_t n);
 
 /**
- * Simple delay function which delays about n microseconds.
- * It is implemented with a nested for-loop and is very approximate.
- * @param  n is the number of usec to wait
+ * Delay function which delays n microseconds.
+ * It is timed by the free-running Timer32 module 1, so it is accurate
+ * at any bus clock that is a multiple of 1 MHz and does not depend on
+ * the optimization level or flash wait states.
+ * @param  n is the number of usec to wait, n times the clock in MHz must be less than 2^32
  * @return none
- * @note This function assumes a 48 MHz clock.
- * This implementation is not very accurate.
- * To improve accuracy, you could tune this function
- * by adjusting the constant within the implementation
- * found in the <b>Clock.c</b> file.
- * For a more accurate time delay, you could use the SysTick module.
- * @brief  Software implementation of a busy-wait delay
+ * @note Busy-waits; the call overhead is well under 1 us at 48 MHz
+ * @see Clock_Micros()
+ * @brief  Hardware timed busy-wait delay
  */
 void Clock_Delay1us(uint32_t n);
 
+/**
+ * Return a monotonic timestamp in microseconds.
+ * Counts from Timer32 module 1 are converted at the clock rate in
+ * effect when they were counted, so the result stays correct across
+ * Clock_Init48MHz() or any other clock change that updates the time base.
+ * @param  none
+ * @return microseconds since the time base started, wraps after 2^32 us (71 minutes)
+ * @note   Timer32 module 1 is reserved for this time base
+ * @brief  Microsecond timestamp
+ */
+uint32_t Clock_Micros(void);
@@ -36,6 +36,7 @@ those of the authors and should not be interpreted as representing official
 policies, either expressed or implied, of the FreeBSD Project.
  */
 #include <stdint.h>
+#include "Priority.h"
 
 
 //*********** DisableInterrupts ***************
@@ -57,21 +58,45 @@ void EnableInterrupts(void){
 }
 //*********** StartCritical ************************
 // make a copy of previous I bit, disable interrupts
+// The compiler intrinsic returns the old PRIMASK as a real
+// return value, so this is safe to inline or reorder around.
 // inputs:  none
 // outputs: previous I bit
-void StartCritical(void){
-  __asm  ("    MRS    R0, PRIMASK   ; save old status \n"
-          "    CPSID  I             ; mask all (except faults)\n"
-          "    BX     LR\n");
+uint32_t StartCritical(void){
+  return _disable_interrupts();   // MRS PRIMASK, CPSID I
 }
 
 //*********** EndCritical ************************
 // using the copy of previous I bit, restore I bit to previous value
 // inputs:  previous I bit
 // outputs: none
-void EndCritical(void){
-  __asm  ("    MSR    PRIMASK, R0\n"
-          "    BX     LR\n");
+void EndCritical(uint32_t sr){
+  _restore_interrupts(sr);        // MSR PRIMASK
+}
+
+//*********** StartMasked ************************
+// mask interrupts at PRIORITY_MASK and below with BASEPRI,
+// higher priority ISRs keep running; never lowers a mask
+// that is already stricter, so calls can nest
+// inputs:  none
+// outputs: previous BASEPRI
+uint32_t StartMasked(void){
+  uint32_t sr, old;
+  sr = _disable_interrupts();
+  old = _set_interrupt_priority(PRIORITY_MASK<<5);   // 3 priority bits, 7-5
+  if(old && (old < (PRIORITY_MASK<<5))){
+    _set_interrupt_priority(old);   // caller already masks more
+  }
+  _restore_interrupts(sr);
+  return old;
+}
+
+//*********** EndMasked ************************
+// restore BASEPRI to its value before StartMasked
+// inputs:  previous BASEPRI
+// outputs: none
+void EndMasked(uint32_t sr){
+  _set_interrupt_priority(sr);
 }
 
 //*********** WaitForInterrupt ************************
@@ -49,6 +49,7 @@ policies, either expressed or implied, of the FreeBSD Project.
  * @defgroup MSP432
  * @brief
  * @{*/
+#include <stdint.h>
 /**
  * Disables Interrupts
  *
@@ -79,7 +80,7 @@ void EnableInterrupts(void);  // Enable interrupts
  *
  * @brief  Saves a copy of PRIMASK and disables interrupts
  */
-long StartCritical(void);    
+uint32_t StartCritical(void);
 
 
 /**
@@ -90,7 +91,28 @@ long StartCritical(void);
  *
  * @brief  Sets PRIMASK with value passed in
  */
-void EndCritical(long sr);    // restore I bit to previous value
+void EndCritical(uint32_t sr); // restore I bit to previous value
+
+/**
+ * Start a section that only blocks interrupts at PRIORITY_MASK and below
+ * (see Priority.h). Higher priority ISRs (PWM, sensor, bumps) still run.
+ *
+ * @param  none
+ * @return copy of BASEPRI before StartMasked called
+ * @note   Nests with itself; never makes an existing mask weaker
+ *
+ * @brief  Saves a copy of BASEPRI and raises it to PRIORITY_MASK
+ */
+uint32_t StartMasked(void);
+/**
+ * End a section started with StartMasked.
+ *
+ * @param  sr is BASEPRI before StartMasked called
+ * @return none
+ *
+ * @brief  Sets BASEPRI with value passed in
+ */
+void EndMasked(uint32_t sr);
 
 
 /**
@@ -0,0 +1,110 @@
+// Curve.c
+// Runs on MSP432 and on the host (sim/)
+// History of motor command turns, straight/curve
+// classification, lookahead braking and the base speed scale.
+// Team Donkey Kong
+
+#include <stdint.h>
+#include "FixedPoint.h"
+#include "Motor.h"
+#include "Reflectance.h"
+#include "FSM.h"             // FSM_Far
+#include "Curve.h"
+#include "Ram.h"
+
+// ------------Curve_Init------------
+// Empty history, curve class, scale 1.0.
+// Input: curve  scheduler
+// Output: none
+void Curve_Init(Curve_t *curve){
+  uint32_t i;
+  for(i = 0; i < CURVE_HISTORY; i++){
+    curve->turn[i] = 0;
+    curve->hard[i] = 0;
+  }
+  curve->index = 0;
+  curve->sum = 0;
+  curve->hardCount = 0;
+  curve->brake = 0;
+  curve->type = CURVE_CLASS_CURVE;
+  curve->scale = FX_Q16_ONE;
+}
+
+// ------------Curve_Update------------
+// Slide the window by one step, classify it, and move the
+// scale toward the target for the class.
+// Input: curve     scheduler
+//        position  estimated position or REFLECTANCE_LOST
+//        velocity  estimated lateral velocity per step
+//        command   MOTOR_CMD() word of this step
+// Output: speed scale, Q16
+RAMFUNC q16_t Curve_Update(Curve_t *curve, int32_t position, int32_t velocity, uint32_t command){
+  uint32_t i = curve->index, hard;
+  int32_t turn, mean, ahead;
+  q16_t target;
+  turn = MOTOR_CMD_RIGHT_SIGNED(command) - MOTOR_CMD_LEFT_SIGNED(command);
+  hard = (MOTOR_CMD_DIR(command) != MOTOR_DIR_FORWARD) || (position == REFLECTANCE_LOST);
+  if(position == REFLECTANCE_LOST){
+    position = 0;
+  }
+  curve->sum += turn - curve->turn[i];
+  curve->hardCount += hard - curve->hard[i];
+  curve->turn[i] = turn;
+  curve->hard[i] = hard;
+  curve->index = (i + 1)&(CURVE_HISTORY-1);
+
+  mean = curve->sum/CURVE_HISTORY;
+  if(mean < 0) mean = -mean;
+  if(curve->hardCount || (mean > CURVE_CURVED)){
+    curve->type = CURVE_CLASS_CURVE;
+  }else if(mean < CURVE_STRAIGHT){
+    curve->type = CURVE_CLASS_STRAIGHT;
+  }                                   // in between: keep the class
+
+  ahead = position + velocity*CURVE_LOOKAHEAD;
+  if(hard || (ahead > FSM_Far) || (ahead < -FSM_Far)){
+    if(curve->scale > FX_Q16_ONE){
+      curve->brake = CURVE_BRAKE_HOLD; // too fast for what is coming
+    }
+  }
+  if(curve->brake){
+    curve->brake--;
+    target = CURVE_BRAKE;
+  }else if(curve->type == CURVE_CLASS_STRAIGHT){
+    target = CURVE_BOOST;
+  }else{
+    target = FX_Q16_ONE;
+  }
+  if(target < curve->scale){
+    curve->scale = target;
+  }else if(curve->scale < target - CURVE_RISE){
+    curve->scale += CURVE_RISE;
+  }else{
+    curve->scale = target;
+  }
+  if(curve->brake){
+    curve->type = CURVE_CLASS_BRAKE;
+  }
+  return curve->scale;
+}
+
+// ------------Curve_Apply------------
+// Scale both duties of a command, keeping its direction.
+// Input: curve    scheduler
+//        command  MOTOR_CMD() word
+// Output: scaled MOTOR_CMD() word
+RAMFUNC uint32_t Curve_Apply(const Curve_t *curve, uint32_t command){
+  int32_t left = MOTOR_CMD_LEFT(command), right = MOTOR_CMD_RIGHT(command);
+  left = FX_ClampDuty(FX_MulQ16(curve->scale, left));
+  right = FX_ClampDuty(FX_MulQ16(curve->scale, right));
+  return MOTOR_CMD(MOTOR_CMD_DIR(command), left, right);
+}
+
+// ------------Curve_Base------------
+// Scale a base duty.
+// Input: curve  scheduler
+//        base   duty at scale 1.0
+// Output: scaled and clamped duty
+int32_t Curve_Base(const Curve_t *curve, int32_t base){
+  return FX_ClampDuty(FX_MulQ16(curve->scale, base));
+}
@@ -0,0 +1,108 @@
+/**
+ * @file      Curve.h
+ * @brief     Straight/curve classifier and base speed scheduler
+ * @details   Keeps the turn of the motor command chosen at each of the
+ * last CURVE_HISTORY steps (right minus left wheel duty, signed); the
+ * position only feeds the lookahead. On a straight the robot either
+ * runs straight or weaves evenly, so the mean turn over the window is
+ * near zero, even when it sits off-center; in a curve the mean is held
+ * to the inside, and hard turns (a wheel reversed) show up. With hysteresis between the two
+ * thresholds that gives a straight/curve class, and the scheduler drives
+ * faster on straights.<br>
+ * The lookahead uses the estimator's lateral velocity: if the position
+ * CURVE_LOOKAHEAD steps ahead would be past FSM_Far, a curve is starting
+ * and the scheduler brakes at once, before the FSM would see the line at
+ * the outer sensors.<br>
+ * The result is a Q16 speed scale: Curve_Apply() multiplies the duties
+ * of an FSM command by it and Curve_Base() a PID base duty. The scale
+ * drops immediately and rises by CURVE_RISE per step.
+ * @author    Team Donkey Kong
+ * @note      Hardware independent, also built by the host simulator
+ ******************************************************************************/
+
+/*!
+ * @defgroup RSLK_Control
+ * @brief
+ * @{*/
+#ifndef CURVE_H_
+#define CURVE_H_
+#include <stdint.h>
+#include "FixedPoint.h"
+
+#define CURVE_HISTORY   256               // steps in the window, power of 2
+#ifndef CURVE_STRAIGHT
+#define CURVE_STRAIGHT  250               // |mean turn| in duty below this is straight
+#endif
+#ifndef CURVE_CURVED
+#define CURVE_CURVED    600               // |mean turn| in duty above this is a curve
+#endif
+#ifndef CURVE_LOOKAHEAD
+#define CURVE_LOOKAHEAD 30                // steps of velocity to look ahead
+#endif
+#ifndef CURVE_BOOST
+#define CURVE_BOOST     FX_Q16(1.4)       // speed scale on a straight
+#endif
+#ifndef CURVE_BRAKE
+#define CURVE_BRAKE     FX_Q16(0.8)       // speed scale after a curve is predicted
+#endif
+#define CURVE_RISE      (FX_Q16_ONE/512)  // largest scale increase per step
+#define CURVE_BRAKE_HOLD 150              // steps to hold CURVE_BRAKE
+
+/**
+ * \brief Track class of the recent window
+ */
+enum Curve_Class { CURVE_CLASS_STRAIGHT, CURVE_CLASS_CURVE, CURVE_CLASS_BRAKE };
+
+/**
+ * \brief History and schedule of one robot
+ */
+struct Curve {
+  int16_t turn[CURVE_HISTORY];     // right minus left duty of each step's command
+  uint8_t hard[CURVE_HISTORY];     // 1 where a wheel was reversed or the line lost
+  uint32_t index;                  // next slot to write
+  int32_t sum;                     // sum of turn[]
+  uint32_t hardCount;              // sum of hard[]
+  uint16_t brake;                  // steps of CURVE_BRAKE left
+  uint8_t type;                    // enum Curve_Class
+  q16_t scale;                     // speed scale in use
+};
+typedef struct Curve Curve_t;
+
+/**
+ * Clear the history; the first window counts as a curve.
+ * @param  curve scheduler
+ * @return none
+ * @brief  Reset the scheduler
+ */
+void Curve_Init(Curve_t *curve);
+
+/**
+ * Add one step to the history and update the class and scale.
+ * @param  curve scheduler
+ * @param  position estimated line position, REFLECTANCE_LOST if lost
+ * @param  velocity estimated lateral velocity per step
+ * @param  command MOTOR_CMD() word chosen for this step, before Curve_Apply()
+ * @return speed scale, Q16
+ * @brief  Update the schedule
+ */
+q16_t Curve_Update(Curve_t *curve, int32_t position, int32_t velocity, uint32_t command);
+
+/**
+ * Scale both duties of a motor command.
+ * @param  curve scheduler
+ * @param  command MOTOR_CMD() word
+ * @return the command with both duties scaled and clamped, same direction
+ * @brief  Schedule an FSM command
+ */
+uint32_t Curve_Apply(const Curve_t *curve, uint32_t command);
+
+/**
+ * Scale a base duty.
+ * @param  curve scheduler
+ * @param  base duty at scale 1.0
+ * @return scaled duty, clamped to the duty range
+ * @brief  Schedule a PID base duty
+ */
+int32_t Curve_Base(const Curve_t *curve, int32_t base);
+
+#endif /* CURVE_H_ */
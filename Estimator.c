@@ -0,0 +1,61 @@
+// Estimator.c
+// Runs on MSP432 and on the host (sim/)
+// Alpha-beta tracker of the line position that predicts
+// through short sensor dropouts.
+// Team Donkey Kong
+
+#include <stdint.h>
+#include "FixedPoint.h"
+#include "Reflectance.h"
+#include "Estimator.h"
+#include "Ram.h"
+
+// ------------Estimator_Init------------
+// Start centered, still and fully confident.
+// Input: est  estimator
+// Output: none
+void Estimator_Init(Estimator_t *est){
+  est->position = 0;
+  est->velocity = 0;
+  est->confidence = FX_Q15_ONE;
+  est->missing = 0;
+}
+
+// ------------Estimator_Update------------
+// Predict, then correct with the measurement if there is one.
+// Confidence moves 1/4 of the way to full on every measured
+// step and loses 1/8 on every missing one.
+// Input: est       estimator
+//        measured  line position or REFLECTANCE_LOST
+// Output: estimated position, REFLECTANCE_LOST once the line
+//         has been missing for ESTIMATOR_HOLD steps or the
+//         prediction has left the sensor bar
+RAMFUNC int32_t Estimator_Update(Estimator_t *est, int32_t measured){
+  int32_t predicted, residual;
+  predicted = FX_Clamp(est->position + est->velocity, -ESTIMATOR_EDGE, ESTIMATOR_EDGE);
+  if(measured == REFLECTANCE_LOST){
+    est->position = predicted;
+    est->confidence -= est->confidence>>3;
+    if(est->missing < 0xFFFF){
+      est->missing++;
+    }
+    if((predicted == ESTIMATOR_EDGE) || (predicted == -ESTIMATOR_EDGE)){
+      est->missing = ESTIMATOR_HOLD + 1;  // ran off the bar, don't wait
+    }
+    if(est->missing > ESTIMATOR_HOLD){
+      return REFLECTANCE_LOST;
+    }
+    return predicted;
+  }
+  if(est->missing > ESTIMATOR_HOLD){
+    predicted = measured;             // found again, the old track means nothing
+    est->velocity = 0;
+  }
+  residual = measured - predicted;
+  est->position = predicted + FX_MulQ16(ESTIMATOR_ALPHA, residual);
+  est->velocity = FX_Clamp(est->velocity + FX_MulQ16(ESTIMATOR_BETA, residual),
+                           -ESTIMATOR_VMAX, ESTIMATOR_VMAX);
+  est->confidence += (FX_Q15_ONE - est->confidence)>>2;
+  est->missing = 0;
+  return est->position;
+}
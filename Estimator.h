@@ -0,0 +1,69 @@
+/**
+ * @file      Estimator.h
+ * @brief     Alpha-beta tracker of the line position
+ * @details   Sits between Reflectance_Position() and the controllers.
+ * Every step it predicts the line position from the last estimate and
+ * its lateral velocity, then corrects both toward the measurement:<br>
+ *   predicted = position + velocity<br>
+ *   position  = predicted + alpha*(measured - predicted)<br>
+ *   velocity  = velocity + beta*(measured - predicted)<br>
+ * When a frame has no line (REFLECTANCE_LOST) the prediction is used
+ * as is and the confidence decays. The line is only reported lost when
+ * it has been missing for ESTIMATOR_HOLD steps or the prediction has
+ * run off the end of the sensor bar, so single dropouts no longer
+ * send the FSM into a Lost state. Integer and Q16 math only.
+ * @author    Team Donkey Kong
+ * @note      Hardware independent, also built by the host simulator
+ ******************************************************************************/
+
+/*!
+ * @defgroup RSLK_Control
+ * @brief
+ * @{*/
+#ifndef ESTIMATOR_H_
+#define ESTIMATOR_H_
+#include <stdint.h>
+#include "FixedPoint.h"
+
+#ifndef ESTIMATOR_ALPHA
+#define ESTIMATOR_ALPHA FX_Q16(0.5)    // position gain
+#endif
+#ifndef ESTIMATOR_BETA
+#define ESTIMATOR_BETA  FX_Q16(0.15)   // velocity gain, about alpha^2/(2-alpha)
+#endif
+#ifndef ESTIMATOR_HOLD
+#define ESTIMATOR_HOLD  25             // steps to predict through before the line is lost
+#endif
+#define ESTIMATOR_EDGE  40000          // |position| past the outer sensors (33400)
+#define ESTIMATOR_VMAX  2000           // largest |velocity| per step
+
+/**
+ * \brief State of one estimator
+ */
+struct Estimator {
+  int32_t position;     // estimated line position, Reflectance_Position() units
+  int32_t velocity;     // position change per step
+  q15_t confidence;     // 0 (no idea) to FX_Q15_ONE (just measured)
+  uint16_t missing;     // consecutive steps without the line
+};
+typedef struct Estimator Estimator_t;
+
+/**
+ * Forget the track, as if the line had just been seen centered.
+ * @param  est estimator
+ * @return none
+ * @brief  Reset an estimator
+ */
+void Estimator_Init(Estimator_t *est);
+
+/**
+ * Run one predict and correct step.
+ * @param  est estimator
+ * @param  measured Reflectance_Position() of the latest sample
+ * @return estimated position, or REFLECTANCE_LOST if the line is lost
+ * @note   Call once per control step, also when the sample is unchanged
+ * @brief  Update the line estimate
+ */
+int32_t Estimator_Update(Estimator_t *est, int32_t measured);
+
+#endif /* ESTIMATOR_H_ */
@@ -0,0 +1,165 @@
+// FSM.c
+// Runs on MSP432 and on the host (sim/)
+// Line-following state machine: tables expanded from FSM_TABLE,
+// the input classifier and the event-driven engine with entry
+// and exit hooks.
+// Team Donkey Kong
+
+#include <stdint.h>
+#include "Reflectance.h"
+#include "Motor.h"
+#include "Estimator.h"
+#include "FSM.h"
+#include "Profile.h"
+#include "Ram.h"
+
+#define FSM_CHECK(name,l,r,dwell,dir,n0,n1,n2,n3,n4,n5,bump,timeout,timer)  \
+  typedef char name##_duty_out_of_range[((l)<=14998 && (r)<=14998 && (dwell)<=0xFFFF && (timeout)<=0xFFFF) ? 1 : -1];
+FSM_TABLE(FSM_CHECK)
+
+uint32_t FSM_Output[FSM_NUM_STATES] = { FSM_TABLE(FSM_OUTPUT) };               // packed motor command
+uint16_t FSM_Dwell[FSM_NUM_STATES] = { FSM_TABLE(FSM_DWELL) };                 // minimum dwell in FSM ticks
+uint16_t FSM_Timeout[FSM_NUM_STATES] = { FSM_TABLE(FSM_TIMEOUT) };             // FSM_TIMER after, 0 never
+const uint8_t FSM_Next[FSM_NUM_STATES][FSM_EVENTS] = { FSM_TABLE(FSM_NEXT) };  // (state, event) -> next
+static FSM_Hook_t Entry[FSM_NUM_STATES];  // entry actions, 0 for none
+static FSM_Hook_t Exit[FSM_NUM_STATES];   // exit actions, 0 for none
+int32_t FSM_Near = FSM_NEAR;
+int32_t FSM_Far = FSM_FAR;
+
+RAMFUNC uint8_t nextStateIDX(int32_t D){
+    // Stop
+    if(D == REFLECTANCE_LOST){
+        return 5;
+    }
+    // Left
+    if(D<=-FSM_Near && D>=-FSM_Far){
+        return 1;
+    }
+    // Hard Left
+    if(D<-FSM_Far){
+        return 2;
+    }
+    // Right
+    if(D>=FSM_Near && D<=FSM_Far){
+        return 3;
+    }
+    // Hard Right
+    if(D>FSM_Far){
+        return 4;
+    }
+    return 0;
+}
+
+// ------------FSM_Init------------
+// Start an FSM in a state. Only the entry hook runs.
+// Input: fsm    FSM to initialize
+//        state  first state
+// Output: none
+void FSM_Init(FSM_t *fsm, uint8_t state){
+    fsm->data = 0;
+    fsm->position = 0;
+    Estimator_Init(&fsm->estimate);
+    fsm->state = state;
+    fsm->dwell = FSM_Dwell[state];
+    fsm->timer = FSM_Timeout[state];
+    fsm->command = FSM_Output[state];
+    if(Entry[state]){
+        Entry[state](fsm);
+    }
+}
+
+// ------------FSM_Enter------------
+// Leave the current state and enter another, or the same
+// one again, with both hooks.
+// Input: fsm    FSM to change
+//        state  new state
+// Output: none
+RAMFUNC void FSM_Enter(FSM_t *fsm, uint8_t state){
+    if(Exit[fsm->state]){
+        Exit[fsm->state](fsm);
+    }
+    fsm->state = state;
+    fsm->dwell = FSM_Dwell[state];
+    fsm->timer = FSM_Timeout[state];
+    fsm->command = FSM_Output[state];
+    if(Entry[state]){
+        Entry[state](fsm);
+    }
+}
+
+// ------------FSM_SetHooks------------
+// Set the entry and exit actions of a state.
+// Input: state  state to change
+//        entry  entry action or 0
+//        exit   exit action or 0
+// Output: none
+void FSM_SetHooks(uint8_t state, FSM_Hook_t entry, FSM_Hook_t exit){
+    if(state < FSM_NUM_STATES){
+        Entry[state] = entry;
+        Exit[state] = exit;
+    }
+}
+
+// ------------FSM_Post------------
+// Follow the transition of one event. An event the table
+// maps back to the current state changes nothing.
+// Input: fsm    FSM to change
+//        event  enum FSM_Event
+// Output: 1 if the state changed, 0 if not
+RAMFUNC int FSM_Post(FSM_t *fsm, uint8_t event){
+    uint8_t next = FSM_Next[fsm->state][event];
+    if(next != fsm->state){
+        FSM_Enter(fsm, next);
+        return 1;
+    }
+    return 0;
+}
+
+// ------------FSM_Observe------------
+// Measure the line position of a sample and run it through
+// the estimator.
+// Input: fsm   FSM to update
+//        data  latest sensor sample
+// Output: none
+RAMFUNC void FSM_Observe(FSM_t *fsm, uint8_t data){
+    int32_t measured;
+    PROFILE_BEGIN(PROFILE_POSITION);
+    fsm->data = data;
+    measured = Reflectance_Position(data);
+    fsm->position = Estimator_Update(&fsm->estimate, measured);
+    PROFILE_END(PROFILE_POSITION);
+}
+
+// ------------FSM_Step------------
+// Update the estimate, run the state timer, hold the current
+// state for its dwell time, then post the frame class picked
+// by the estimate. The estimator runs every step, dwell or
+// not, so it sees every sample. Once the dwell has expired
+// the input is re-checked every step instead of once per delay.
+// Input: fsm   FSM to step
+//        data  latest sensor sample
+// Output: 1 if the state changed, 0 if not
+RAMFUNC int FSM_Step(FSM_t *fsm, uint8_t data){
+    uint8_t input;
+    FSM_Observe(fsm, data);
+    if(fsm->timer){
+        fsm->timer--;
+        if((fsm->timer == 0) && FSM_Post(fsm, FSM_TIMER)){
+            return 1;
+        }
+    }
+    if(fsm->dwell){
+        fsm->dwell--;
+        return 0;
+    }
+    {
+        PROFILE_BEGIN(PROFILE_NEXTSTATE);
+        input = nextStateIDX(fsm->position);
+        PROFILE_END(PROFILE_NEXTSTATE);
+    }
+    if(FSM_Post(fsm, input)){           // next depends on input and state
+        return 1;
+    }
+    fsm->command = FSM_Output[fsm->state];
+    return 0;
+}
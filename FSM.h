@@ -0,0 +1,192 @@
+/**
+ * @file      FSM.h
+ * @brief     Line-following state machine
+ * @details   The FSM table, the input classifier nextStateIDX() and an
+ * event-driven engine. Nothing here touches a register: a step takes
+ * the latest 8-bit sensor sample and leaves a MOTOR_CMD() word in the
+ * FSM_t. The position the transitions see comes from an Estimator_t,
+ * so a short dropout is bridged instead of read as Lost. On the robot,
+ * main() feeds Reflectance_Get() and hands the command to the motors;
+ * the host simulator in sim/ feeds samples from a track model or a
+ * recorded trace instead.<br>
+ * Every transition is caused by an event: the class of a sensor frame
+ * (FSM_CENTER to FSM_LOST), FSM_BUMP, or FSM_TIMER when a state's
+ * timeout runs out. The next state is one table lookup, and the exit
+ * hook of the old state and the entry hook of the new one run on the
+ * way, so a transition takes the same time whatever the table.
+ * @author    Team Donkey Kong
+ ******************************************************************************/
+
+/*!
+ * @defgroup RSLK_Control
+ * @brief
+ * @{*/
+#ifndef FSM_H_
+#define FSM_H_
+#include <stdint.h>
+#include "Motor.h"
+#include "Estimator.h"
+
+/**
+ * \brief Defaults of the nextStateIDX() thresholds in Reflectance_Position() units
+ */
+#ifndef FSM_NEAR
+#define FSM_NEAR 14300      // |position| at which a correction starts
+#endif
+#ifndef FSM_FAR
+#define FSM_FAR  23800      // |position| beyond which the correction is hard
+#endif
+
+#define FSM_LOST_TIMEOUT 3000  // ticks of searching before giving up in Stop
+
+// FSM description, one line per state:
+//   X(name, L_Duty, R_Duty, dwell, direction, next for input 0..5,
+//     next on a bump, timeout, next on timeout)
+// L_Duty/R_Duty are 0-14998, dwell is the minimum time in the state
+// in FSM ticks (1ms), direction is a MOTOR_DIR_ value, and input is
+// the index returned by nextStateIDX(). Frame events are only looked
+// at once the dwell is over; a bump always is. A timeout of 0 ticks
+// means the state has no timer. The macros below expand this one list
+// into the state enum, the transition table in flash and the motor
+// commands, dwells and timeouts, which are in RAM so they can be tuned
+// at run time (Param.h) and start from the values listed here.
+// Define FSM_TABLE before including this file to try another table
+// (the host simulator does this with -include).
+#ifndef FSM_TABLE
+#define FSM_TABLE(X) \
+  X(L_Center, 7000, 7000,  30, MOTOR_DIR_FORWARD, L_Center, Left, H_left, Right, H_right, L_Lost,   Stop, 0, L_Center) /* Left Center */ \
+  X(R_Center, 7000, 7000,  30, MOTOR_DIR_FORWARD, R_Center, Left, H_left, Right, H_right, R_Lost,   Stop, 0, R_Center) /* Right Center */ \
+  X(Left,     7000, 6000,  20, MOTOR_DIR_FORWARD, L_Center, Left, H_left, Right, H_right, L_Center, Stop, 0, Left    ) /* Left of line (turn right) */ \
+  X(H_left,   4000, 1500,  20, MOTOR_DIR_RIGHT,   L_Center, Left, H_left, Right, H_right, L_Lost,   Stop, 0, H_left  ) /* H_left of line (turn hard right) */ \
+  X(Right,    6000, 7000,  20, MOTOR_DIR_FORWARD, R_Center, Left, H_left, Right, H_right, R_Center, Stop, 0, Right   ) /* Right of line (turn left) */ \
+  X(H_right,  1500, 4000,  20, MOTOR_DIR_LEFT,    R_Center, Left, H_left, Right, H_right, R_Lost,   Stop, 0, H_right ) /* H_right of line (turn hard left) */ \
+  X(L_Lost,   4500, 4000,  30, MOTOR_DIR_RIGHT,   L_Center, Left, H_left, Right, H_right, L_Lost,   Stop, FSM_LOST_TIMEOUT, Stop) /* Left lost, search */ \
+  X(R_Lost,   4000, 4500,  30, MOTOR_DIR_LEFT,    R_Center, Left, H_left, Right, H_right, R_Lost,   Stop, FSM_LOST_TIMEOUT, Stop) /* Right lost, search */ \
+  X(Stop,        0,    0, 500, MOTOR_DIR_FORWARD, Stop,     Stop, Stop,   Stop,  Stop,    Stop,     Stop, 0, Stop    ) /* Stop */
+#endif
+
+/**
+ * \brief Events that drive the transitions
+ */
+enum FSM_Event {
+  FSM_CENTER,       // frame classes, the values nextStateIDX() returns
+  FSM_LEFT,
+  FSM_HARD_LEFT,
+  FSM_RIGHT,
+  FSM_HARD_RIGHT,
+  FSM_LOST,
+  FSM_BUMP,         // a bump switch closed
+  FSM_TIMER,        // the state's timeout ran out
+  FSM_EVENTS
+};
+#define FSM_INPUTS 6   // number of values nextStateIDX() can return
+
+#define FSM_ENUM(name,l,r,dwell,dir,n0,n1,n2,n3,n4,n5,bump,timeout,timer)    name,
+#define FSM_OUTPUT(name,l,r,dwell,dir,n0,n1,n2,n3,n4,n5,bump,timeout,timer)  MOTOR_CMD(dir,l,r),
+#define FSM_DWELL(name,l,r,dwell,dir,n0,n1,n2,n3,n4,n5,bump,timeout,timer)   dwell,
+#define FSM_TIMEOUT(name,l,r,dwell,dir,n0,n1,n2,n3,n4,n5,bump,timeout,timer) timeout,
+#define FSM_NEXT(name,l,r,dwell,dir,n0,n1,n2,n3,n4,n5,bump,timeout,timer)    {n0,n1,n2,n3,n4,n5,bump,timer},
+
+enum FSM_State { FSM_TABLE(FSM_ENUM) FSM_NUM_STATES };
+
+extern uint32_t FSM_Output[FSM_NUM_STATES];               // packed motor command
+extern uint16_t FSM_Dwell[FSM_NUM_STATES];                // minimum dwell in FSM ticks
+extern uint16_t FSM_Timeout[FSM_NUM_STATES];              // FSM_TIMER after this many ticks, 0 never
+extern const uint8_t FSM_Next[FSM_NUM_STATES][FSM_EVENTS]; // (state, event) -> next
+extern int32_t FSM_Near;    // nextStateIDX() thresholds, FSM_NEAR and FSM_FAR at reset
+extern int32_t FSM_Far;
+
+/**
+ * \brief State of one FSM instance
+ */
+struct FSM {
+  uint8_t state;        // index of the current state
+  uint8_t data;         // latest sensor sample
+  uint16_t dwell;       // steps left before frame events are looked at
+  uint16_t timer;       // steps left before FSM_TIMER, 0 if not running
+  int32_t position;     // estimated line position, REFLECTANCE_LOST if lost
+  uint32_t command;     // MOTOR_CMD() word for the current state
+  Estimator_t estimate; // tracks the line through dropouts
+};
+typedef struct FSM FSM_t;
+
+/**
+ * \brief Entry or exit action of a state
+ */
+typedef void (*FSM_Hook_t)(FSM_t *fsm);
+
+/**
+ * Start an FSM in a state.
+ * @param  fsm FSM to initialize
+ * @param  state first state
+ * @return none
+ * @brief  Initialize an FSM
+ */
+void FSM_Init(FSM_t *fsm, uint8_t state);
+
+/**
+ * Jump to a state: run the exit hook of the current state, load the
+ * dwell, timer and motor command of the new one, run its entry hook.
+ * @param  fsm FSM to change
+ * @param  state new state
+ * @return none
+ * @note   Entering the current state runs both hooks and restarts it
+ * @brief  Enter a state
+ */
+void FSM_Enter(FSM_t *fsm, uint8_t state);
+
+/**
+ * Set the entry and exit actions of a state.
+ * @param  state state to change
+ * @param  entry called after the state is entered, 0 for none
+ * @param  exit called before the state is left, 0 for none
+ * @return none
+ * @note   Hooks run inside FSM_Step(), FSM_Post() or FSM_Enter() and
+ * must not change the state themselves
+ * @brief  Attach state actions
+ */
+void FSM_SetHooks(uint8_t state, FSM_Hook_t entry, FSM_Hook_t exit);
+
+/**
+ * Deliver one event: follow its transition from the current state.
+ * @param  fsm FSM to change
+ * @param  event enum FSM_Event
+ * @return 1 if the state changed, 0 if the table keeps the state
+ * @note   Ignores the dwell; FSM_Step() only posts frame events after it
+ * @brief  Post an event
+ */
+int FSM_Post(FSM_t *fsm, uint8_t event);
+
+/**
+ * Classify a line position into an FSM input.
+ * @param  D line position from Reflectance_Position() or the estimate,
+ * REFLECTANCE_LOST when there is none
+ * @return 0 centered, 1 left, 2 hard left, 3 right, 4 hard right, 5 lost
+ * @brief  FSM input from the line position
+ */
+uint8_t nextStateIDX(int32_t D);
+
+/**
+ * Feed a sample to the line estimator without stepping the machine.
+ * @param  fsm FSM whose data, position and estimate are updated
+ * @param  data latest 8-bit sensor sample
+ * @return none
+ * @note   FSM_Step() does this itself; call it when another controller
+ * drives the motors (PID mode) so the estimate keeps up
+ * @brief  Update the line estimate
+ */
+void FSM_Observe(FSM_t *fsm, uint8_t data);
+
+/**
+ * Run one step: update the line estimate, count the timer down and
+ * post FSM_TIMER when it runs out, hold the state while its dwell
+ * lasts, then post the class of the frame.
+ * @param  fsm FSM to step
+ * @param  data latest 8-bit sensor sample
+ * @return 1 if the state changed, 0 if not
+ * @note   Once the dwell has expired the input is checked every step
+ * @brief  Step the FSM
+ */
+int FSM_Step(FSM_t *fsm, uint8_t data);
+
+#endif /* FSM_H_ */
@@ -0,0 +1,201 @@
+/**
+ * @file      FixedPoint.h
+ * @brief     Header-only fixed-point math for the control path
+ * @details   Q16 (16.16) and Q15 (1.15) helpers for the Cortex-M4F.
+ * Everything is a static inline function, so only the operations a file
+ * uses are compiled into it. On the target the saturating operations use
+ * the CMSIS DSP intrinsics; define FX_NO_DSP to get the portable C
+ * versions (same results) for a host build.<br>
+ * None of them has been timed on the target; the Benchmark configuration
+ * is the place to measure one before relying on it in a hot path.
+ * @author    Team Donkey Kong
+ ******************************************************************************/
+
+/*!
+ * @defgroup RSLK_Control
+ * @brief
+ * @{*/
+#ifndef FIXEDPOINT_H_
+#define FIXEDPOINT_H_
+#include <stdint.h>
+
+#ifndef FX_NO_DSP
+#include "msp.h"            // CMSIS __QADD, __QSUB, __SSAT, __SMLAD
+#endif
+
+/**
+ * \brief Signed 16.16 fixed-point value
+ */
+typedef int32_t q16_t;
+
+/**
+ * \brief Signed 1.15 fixed-point value
+ */
+typedef int16_t q15_t;
+
+#define FX_Q16_ONE 65536            // 1.0 in Q16
+#define FX_Q15_ONE 32767            // largest Q15 value, just under 1.0
+#define FX_DUTY_MAX 14998           // largest motor duty, see Motor.h
+
+/**
+ * \brief Convert a constant to Q16 at compile time, e.g. FX_Q16(0.125)
+ */
+#define FX_Q16(x) ((q16_t)((x)*65536.0 + (((x) >= 0) ? 0.5 : -0.5)))
+
+/**
+ * Saturating 32-bit add.
+ * @param  a first operand
+ * @param  b second operand
+ * @return a+b clamped to INT32_MIN..INT32_MAX
+ * @brief  Saturating add
+ */
+static inline int32_t FX_SatAdd(int32_t a, int32_t b){
+#ifndef FX_NO_DSP
+  return __QADD(a, b);
+#else
+  int64_t s = (int64_t)a + b;
+  if(s > INT32_MAX) return INT32_MAX;
+  if(s < INT32_MIN) return INT32_MIN;
+  return (int32_t)s;
+#endif
+}
+
+/**
+ * Saturating 32-bit subtract.
+ * @param  a first operand
+ * @param  b second operand
+ * @return a-b clamped to INT32_MIN..INT32_MAX
+ * @brief  Saturating subtract
+ */
+static inline int32_t FX_SatSub(int32_t a, int32_t b){
+#ifndef FX_NO_DSP
+  return __QSUB(a, b);
+#else
+  int64_t s = (int64_t)a - b;
+  if(s > INT32_MAX) return INT32_MAX;
+  if(s < INT32_MIN) return INT32_MIN;
+  return (int32_t)s;
+#endif
+}
+
+/**
+ * Saturate to a signed 16-bit value.
+ * @param  x value to saturate
+ * @return x clamped to -32768..32767
+ * @brief  Saturate to 16 bits
+ */
+static inline int32_t FX_Sat16(int32_t x){
+#ifndef FX_NO_DSP
+  return __SSAT(x, 16);
+#else
+  if(x > 32767) return 32767;
+  if(x < -32768) return -32768;
+  return x;
+#endif
+}
+
+/**
+ * Q16 multiply, truncating toward minus infinity.
+ * @param  a Q16 operand
+ * @param  b Q16 (or integer) operand
+ * @return (a*b)>>16, only the low 32 bits are kept
+ * @note   Use FX_MulSatQ16 when the product can exceed 32767.0
+ * @brief  Q16 multiply
+ */
+static inline q16_t FX_MulQ16(q16_t a, int32_t b){
+  return (q16_t)(((int64_t)a*b)>>16);
+}
+
+/**
+ * Saturating Q16 multiply.
+ * @param  a Q16 operand
+ * @param  b Q16 (or integer) operand
+ * @return (a*b)>>16 clamped to INT32_MIN..INT32_MAX
+ * @brief  Saturating Q16 multiply
+ */
+static inline q16_t FX_MulSatQ16(q16_t a, int32_t b){
+  int64_t p = ((int64_t)a*b)>>16;
+  if(p > INT32_MAX) return INT32_MAX;
+  if(p < INT32_MIN) return INT32_MIN;
+  return (q16_t)p;
+}
+
+/**
+ * Saturating Q15 multiply.
+ * @param  a Q15 operand
+ * @param  b Q15 operand
+ * @return (a*b)>>15 clamped to Q15 (only -1.0*-1.0 saturates)
+ * @brief  Q15 multiply
+ */
+static inline q15_t FX_MulQ15(q15_t a, q15_t b){
+  return (q15_t)FX_Sat16(((int32_t)a*b)>>15);
+}
+
+/**
+ * Dual 16-bit multiply-accumulate: acc + x.lo*y.lo + x.hi*y.hi.
+ * @param  x two packed signed 16-bit values
+ * @param  y two packed signed 16-bit values
+ * @param  acc accumulator
+ * @return updated accumulator
+ * @brief  Dual multiply-accumulate
+ */
+static inline int32_t FX_Dot2Q15(uint32_t x, uint32_t y, int32_t acc){
+#ifndef FX_NO_DSP
+  return (int32_t)__SMLAD(x, y, (uint32_t)acc);
+#else
+  return acc + (int32_t)(int16_t)x*(int16_t)y +
+               (int32_t)(int16_t)(x>>16)*(int16_t)(y>>16);
+#endif
+}
+
+/**
+ * Clamp a value to a range.
+ * @param  x value
+ * @param  lo lower limit
+ * @param  hi upper limit
+ * @return x clamped to lo..hi
+ * @brief  Clamp to a range
+ */
+static inline int32_t FX_Clamp(int32_t x, int32_t lo, int32_t hi){
+  if(x < lo) return lo;
+  if(x > hi) return hi;
+  return x;
+}
+
+/**
+ * Clamp to the motor duty range.
+ * @param  x requested duty
+ * @return x clamped to 0..FX_DUTY_MAX
+ * @brief  Clamp to motor duty
+ */
+static inline int32_t FX_ClampDuty(int32_t x){
+  return FX_Clamp(x, 0, FX_DUTY_MAX);
+}
+
+/**
+ * Q16 reciprocal of a small integer from a table.
+ * @param  n divisor, 1 to 16
+ * @return round(65536/n) in Q16, 0 if n is out of range
+ * @brief  Reciprocal of 1 to 16
+ */
+static inline uint32_t FX_RecipQ16(uint32_t n){
+  static const uint32_t recip[17] = {
+        0, 65536, 32768, 21845, 16384, 13107, 10923,  9362,
+     8192,  7282,  6554,  5958,  5461,  5041,  4681,  4369, 4096 };
+  return (n <= 16)? recip[n] : 0;
+}
+
+/**
+ * Divide by a small integer using the reciprocal table.
+ * @param  x dividend, |x| < 131072
+ * @param  n divisor, 1 to 16
+ * @return x/n rounded toward minus infinity, give or take 1 since the
+ * table reciprocals are rounded (e.g. 3/3 gives 0); exact when n is a
+ * power of two
+ * @brief  Divide by 1 to 16
+ */
+static inline int32_t FX_DivRecip(int32_t x, uint32_t n){
+  return (int32_t)(((int64_t)x*FX_RecipQ16(n))>>16);
+}
+
+#endif /* FIXEDPOINT_H_ */
@@ -0,0 +1,85 @@
+// Flash.c
+// Runs on MSP432
+// Sector erase and immediate-mode word programming of bank 1
+// of the main flash through the flash controller.
+// Team Donkey Kong
+
+#include <stdint.h>
+#include "msp.h"
+#include "Flash.h"
+
+#define BUSY 0x00030000                // STATUS field of PRG_CTLSTAT and ERASE_CTLSTAT
+
+// ERASE_CTLSTAT STATUS, bits 17-16 (TRM, FLCTL_ERASE_CTLSTAT):
+//   00b idle, no erase operation currently active
+//   01b erase operation triggered to start
+//   10b erase operation in progress
+//   11b erase operation completed, status held until CLR_STAT
+// so the end of an erase is not STATUS == 0 as for programming.
+#define ERASE_TRIGGERED 0x00010000
+#define ERASE_ACTIVE    0x00020000
+#define ERASE_ADDR_ERR  0x00040000
+#define ERASE_CLR_STAT  0x00080000
+
+// Check that [address, address+bytes) is inside bank 1
+static int InBank1(uint32_t address, uint32_t bytes){
+  return (address >= FLASH_BANK1) && (bytes <= 2*FLASH_BANK1 - address);
+}
+
+// ------------Flash_Erase------------
+// Unprotect the sector, erase it, protect it again.
+// Input: address  first address of a sector in bank 1
+// Output: 1 if erased, 0 on error
+int Flash_Erase(uint32_t address){
+  uint32_t sector, status, failed;
+  if(!InBank1(address, FLASH_SECTOR_SIZE) || (address&(FLASH_SECTOR_SIZE-1))){
+    return 0;
+  }
+  sector = (address - FLASH_BANK1)/FLASH_SECTOR_SIZE;
+  FLCTL->CLRIFG = 0xFFFFFFFF;
+  FLCTL->BANK1_MAIN_WEPROT &= ~(1u<<sector); // allow writes to this sector only
+  FLCTL->ERASE_CTLSTAT = ERASE_CLR_STAT;
+  FLCTL->ERASE_SECTADDR = address;
+  FLCTL->ERASE_CTLSTAT = 0x00000001;         // START, sector mode, main memory
+  do{
+    status = FLCTL->ERASE_CTLSTAT&BUSY;
+  }while((status == ERASE_TRIGGERED) || (status == ERASE_ACTIVE));
+  failed = FLCTL->ERASE_CTLSTAT&ERASE_ADDR_ERR;
+  FLCTL->ERASE_CTLSTAT = ERASE_CLR_STAT;     // completed (11b) back to idle
+  FLCTL->BANK1_MAIN_WEPROT |= (1u<<sector);
+  return !failed;
+}
+
+// ------------Flash_Write------------
+// Program words one at a time in immediate mode with
+// pre- and post-verify, then read each one back.
+// Input: address  word-aligned destination in bank 1
+//        data     words to write
+//        count    number of words
+// Output: 1 if all words verified, 0 on error
+int Flash_Write(uint32_t address, const uint32_t *data, uint32_t count){
+  volatile uint32_t *dst = (volatile uint32_t *)address;
+  uint32_t i, first, last, mask = 0, ok = 1;
+  if(!InBank1(address, 4*count) || (address&3) || (count == 0)){
+    return 0;
+  }
+  first = (address - FLASH_BANK1)/FLASH_SECTOR_SIZE;
+  last = (address + 4*count - 1 - FLASH_BANK1)/FLASH_SECTOR_SIZE;
+  for(i = first; i <= last; i++){
+    mask |= 1u<<i;
+  }
+  FLCTL->CLRIFG = 0xFFFFFFFF;
+  FLCTL->BANK1_MAIN_WEPROT &= ~mask;
+  FLCTL->PRG_CTLSTAT = 0x0000000D;           // ENABLE, immediate mode, VER_PRE, VER_PST
+  for(i = 0; i < count; i++){
+    dst[i] = data[i];                        // starts the program operation
+    while(FLCTL->PRG_CTLSTAT&BUSY){};
+    if((FLCTL->IFG&0x00000206) || (dst[i] != data[i])){ // AVPRE, AVPST, PRG_ERR
+      ok = 0;
+      break;
+    }
+  }
+  FLCTL->PRG_CTLSTAT = 0;                    // back to read mode
+  FLCTL->BANK1_MAIN_WEPROT |= mask;
+  return ok;
+}
@@ -0,0 +1,44 @@
+/**
+ * @file      Flash.h
+ * @brief     Erase and program the MSP432 main flash
+ * @details   Blocking sector erase and word programming through the
+ * flash controller (FLCTL), with pre- and post-verify. Used to keep a
+ * few hundred bytes of settings across resets, not for logging: each
+ * sector is good for about 20000 erase cycles.
+ * @author    Team Donkey Kong
+ * @note      Only bank 1 (0x20000-0x3FFFF) may be written. This code
+ * runs from bank 0, so it keeps executing while bank 1 is busy.
+ ******************************************************************************/
+
+/*!
+ * @defgroup MSP432
+ * @brief
+ * @{*/
+#ifndef FLASH_H_
+#define FLASH_H_
+#include <stdint.h>
+
+#define FLASH_SECTOR_SIZE 0x1000      // 4 KB
+#define FLASH_BANK1       0x00020000  // first address of bank 1
+
+/**
+ * Erase one 4 KB sector of bank 1.
+ * @param  address first address of the sector
+ * @return 1 on success, 0 if the address is not in bank 1 or the erase failed
+ * @note   Takes up to about 100 ms; interrupts stay enabled
+ * @brief  Erase a flash sector
+ */
+int Flash_Erase(uint32_t address);
+
+/**
+ * Program words into erased flash in bank 1.
+ * @param  address destination, word aligned
+ * @param  data words to write
+ * @param  count number of 32-bit words
+ * @return 1 if every word verified, 0 on a bad address or a program error
+ * @note   The sector must have been erased with Flash_Erase()
+ * @brief  Program flash
+ */
+int Flash_Write(uint32_t address, const uint32_t *data, uint32_t count);
+
+#endif /* FLASH_H_ */
@@ -5,107 +5,304 @@
 #include "BumpInt.h"
 #include "Reflectance.h"
 #include "Motor.h"
+#include "Scheduler.h"
+#include "PID.h"
+#include "FixedPoint.h"
+#include "Profile.h"
+#include "Telemetry.h"
+#include "Speed.h"
+#include "Power.h"
+#include "Boot.h"
+#include "Ram.h"
+#include "FSM.h"
+#include "Calibrate.h"
+#include "Curve.h"
+#include "TrackMap.h"
+#include "Tachometer.h"
+#include "Param.h"
+#include "Supervisor.h"
+#include "Battery.h"
 
+#define TICK_RATE     1000  // scheduler tick in Hz (1 ms)
+#define SAMPLE_SLACK   100  // us of charge and dead time added to the sample time
+                            // for the TIMER_A1 period (1100 us at 1000 us)
+#define PARAM_PERIOD     1  // parameter commands every tick, before the FSM
+#define FSM_PERIOD       1  // FSM step every 1 tick (1 kHz)
+#define MOTOR_PERIOD    10  // motor update every 10 ticks (100 Hz)
+#define LOG_PERIOD       1  // telemetry record every tick (1 kHz)
+#define BUMP_PERIOD      1  // bump debounce every tick (1 kHz)
+#define ADAPT_PERIOD    64  // sample time adaptation every 64 ticks
+#define SUPERVISOR_PERIOD 1 // deadline check and watchdog every tick, last
 
-// Linked data structure
-struct State {
-  uint16_t L_Duty;             // 0-14998
-  uint16_t R_Duty;             // 0-14998
-  uint32_t delay;              // time to delay in 1ms
-  uint8_t function;
-  const struct State *next[6]; // Next if 3-bit input is 0-7
-};
-typedef const struct State State_t;
-
-#define L_Center &fsm[0]
-#define R_Center &fsm[1]
-#define Left   &fsm[2]
-#define H_left &fsm[3]
-#define Right  &fsm[4]
-#define H_right &fsm[5]
-#define L_Lost &fsm[6]
-#define R_Lost &fsm[7]
-#define Stop   &fsm[8]
-State_t fsm[9]={
-  {7000, 7000,  30, 0, { L_Center, Left, H_left, Right, H_right, L_Lost }},   // Left Center
-  {7000, 7000,  30, 0, { R_Center, Left, H_left, Right, H_right, R_Lost }},   // Right Center
-  {7000, 6000,  20, 0, { L_Center, Left, H_left, Right, H_right, L_Center }},  // Left of line (turn right)
-  {4000, 1500,  20, 1, { L_Center, Left, H_left, Right, H_right, L_Lost }},  // H_left of line (turn hard right)
-  {6000, 7000,  20, 0, { R_Center, Left, H_left, Right, H_right, R_Center }},  // Right of line (turn left)
-  {1500, 4000,  20, 2, { R_Center, Left, H_left, Right, H_right, R_Lost }},  // H_right of line (turn hard left)
-  {4500, 4000,  30, 1, { L_Center, Left, H_left, Right, H_right, L_Lost }},  // Left lost
-  {4000, 4500,  30, 2, { R_Center, Left, H_left, Right, H_right, R_Lost }},  // Right lost
-  {   0,    0, 500, 0, { Stop,   Stop, Stop,  Stop, Stop, Stop }}   // Stop
+#define CAL_DUTY      2500  // spin duty while calibrating
+#define CAL_SAMPLES    400  // calibration measurements, 5 ms apart (2 s)
+
+// Steering modes
+#define MODE_FSM 0          // nine fixed duty pairs from FSM_TABLE
+#define MODE_PID 1          // continuous PID steering, FSM Lost/Stop as fallback
+#ifndef CONTROL_MODE
+#define CONTROL_MODE MODE_FSM
+#endif
+#define PID_BASE     7000   // base duty of both wheels in PID mode
+#define PID_KP   FX_Q16(0.125)    // duty per unit of position
+#define PID_KI   FX_Q16(0.00025)  // per update
+#define PID_KD   FX_Q16(0.5)      // per update
+#define PID_IMAX   400000   // integrator clamp
+
+// 1: the FSM command is a speed for the per-wheel speed loop (Speed.c),
+// 0: its duties go straight to the motors
+#define SPEED_LOOP 1
+
+static FSM_t Fsm;         // state, latest sample, position and motor command
+static Calibrate_Profile_t Cal;  // reflectance calibration, from flash or learned at boot
+static Curve_t Ahead;     // straight/curve history and base speed scale
+static TrackMap_t Map;    // learned lap and its speed plan, 4 KB
+static uint8_t Racing;    // 1 while Map has a plan for this lap
+static uint32_t Exported; // map segments sent to telemetry since the plan
+static uint32_t Frame;    // sensor frame used by the last PID update
+uint8_t Mode = CONTROL_MODE;
+PID_t Steer;
+static uint16_t SampleTime;  // sample time set over the UART, 0 for the calibrated one
+
+// Pin the sample time, or go back to the calibrated one and its
+// adaptation range when set to 0. A pinned time below
+// REFLECTANCE_MIN_TIME is raised to it, and a GET shows the raise.
+static void SampleTimeChanged(int32_t time){
+    if(time == 0){
+        Reflectance_SetTime(Cal.time);
+        Reflectance_SetLimits(Cal.minTime, Cal.maxTime);
+    }else{
+        if(time < REFLECTANCE_MIN_TIME){
+            time = REFLECTANCE_MIN_TIME;
+            SampleTime = time;
+        }
+        Reflectance_SetLimits(time, time);
+        Reflectance_SetTime(time);
+    }
+}
+
+// Tunable parameters, the index is the ID used on the UART:
+//   0 FSM_Near, 1 FSM_Far, 2 sample time in us (0 = calibrated,
+//   else at least REFLECTANCE_MIN_TIME),
+//   then for each FSM_TABLE state in order: left duty, right duty,
+//   dwell, timeout
+#define PARAM_FSM(name,l,r,dwell,dir,n0,n1,n2,n3,n4,n5,bump,timeout,timer) \
+    {&FSM_Output[name], 0, FX_DUTY_MAX, l, PARAM_DUTY_LEFT, 0}, \
+    {&FSM_Output[name], 0, FX_DUTY_MAX, r, PARAM_DUTY_RIGHT, 0}, \
+    {&FSM_Dwell[name], 0, 0xFFFF, dwell, PARAM_UINT16, 0}, \
+    {&FSM_Timeout[name], 0, 0xFFFF, timeout, PARAM_UINT16, 0},
+static const Param_t Params[] = {
+    {&FSM_Near, 0, 40000, FSM_NEAR, PARAM_INT32, 0},
+    {&FSM_Far, 0, 40000, FSM_FAR, PARAM_INT32, 0},
+    {&SampleTime, 0, CALIBRATE_TIMEOUT, 0, PARAM_UINT16, &SampleTimeChanged},
+    FSM_TABLE(PARAM_FSM)
 };
 
-State_t *Spt;  // pointer to the current state
+// Continuous steering. A negative position means the robot is left
+// of the line, so the controller output speeds up the left wheel.
+// The position is the estimate, and the output is scaled down to
+// half while the estimator is predicting through a dropout. When
+// it gives up, control goes to the FSM Lost state on the side the
+// line was last tracked.
+RAMFUNC static void PID_Step(void){
+    int32_t position, u, base, left, right;
 
-void PORT4_IRQHandler(void){
-    // write this as part of Lab 14
-    P4->IFG &= ~0xED; // clear flags
-    Spt = Stop;
+    if(Reflectance_Frames() == Frame){
+        return;                    // no new sample since the last update
+    }
+    Frame = Reflectance_Frames();
+    position = Fsm.position;       // estimate, updated by FSM_Task
+    if(position == REFLECTANCE_LOST){
+        FSM_Enter(&Fsm, (Fsm.estimate.position < 0)? L_Lost : R_Lost);
+        return;
+    }
+    u = PID_Update(&Steer, position);
+    u = FX_MulQ15(FX_Sat16(u), (FX_Q15_ONE + Fsm.estimate.confidence)/2);  // half to full authority
+    base = Curve_Base(&Ahead, PID_BASE);
+    left = FX_ClampDuty(base - u);
+    right = FX_ClampDuty(base + u);
+    Fsm.command = MOTOR_CMD(MOTOR_DIR_FORWARD, left, right);
 }
 
-uint8_t nextStateIDX(int32_t D, uint8_t bits){
-    // Left
-    if(D<=-14300 && D>=-23800){
-        return 1;
+// Leaving Lost in PID mode: the line is back, the PID takes over
+// next tick without the old integrator
+static void LostExit(FSM_t *fsm){
+    (void)fsm;
+    if(Mode == MODE_PID){
+        PID_Reset(&Steer);
     }
-    // Hard Left
-    if(D<-23800){
-        return 2;
+}
+
+// Entering Stop: cut the drivers now instead of at the next
+// Motor_Task
+static void StopEntry(FSM_t *fsm){
+    (void)fsm;
+    Motor_Stop();
+}
+
+// One control tick: collisions first, then PID steering or an
+// FSM step on the latest sample, then the speed schedule. In
+// PID mode the FSM only runs while Lost or stopped.
+RAMFUNC void FSM_Task(void){
+    BumpEvent_t bump;
+    uint8_t state;
+    int32_t distance;              // mm, mean of both wheels
+    PROFILE_BEGIN(PROFILE_FSM);
+
+    while(BumpInt_Get(&bump)){     // at most BUMP_QUEUE events
+        FSM_Post(&Fsm, FSM_BUMP);
     }
-    // Right
-    if(D>=14300 && D<=23800){
-        return 3;
+    if(Supervisor_Tripped() && (Fsm.state != Stop)){
+        FSM_Enter(&Fsm, Stop);     // a deadline was missed, the motors are already off
     }
-    // Hard Right
-    if(D>23800){
-        return 4;
+    state = Fsm.state;
+    if((Mode == MODE_PID) && (state != L_Lost) && (state != R_Lost) && (state != Stop)){
+        FSM_Observe(&Fsm, Reflectance_Get());
+        PID_Step();
+    }else{
+        FSM_Step(&Fsm, Reflectance_Get());
     }
-    // Stop
-    if(bits == 0x00000000){
-        return 5;
+    Curve_Update(&Ahead, Fsm.position, Fsm.estimate.velocity, Fsm.command);
+    distance = (Tachometer_Steps(TACH_LEFT) + Tachometer_Steps(TACH_RIGHT))*TACH_UM_PER_STEP/2000;
+    Racing = TrackMap_Step(&Map, distance, Fsm.data, Fsm.position, Fsm.command);
+    PROFILE_END(PROFILE_FSM);
+}
+
+// Apply the latest motor command, scaled by the map plan on a
+// racing lap or the speed schedule otherwise in FSM mode, through
+// the speed loop if enabled
+void Motor_Task(void){
+    uint32_t command = Fsm.command;
+    PROFILE_BEGIN(PROFILE_MOTOR);
+    Boot_Mark(BOOT_DRIVE);         // only the first call is recorded
+    if(Mode == MODE_FSM){
+        if(Racing){
+            command = TrackMap_Apply(&Map, command);
+        }else{
+            command = Curve_Apply(&Ahead, command);  // FSM_TABLE duties are at scale 1.0
+        }
+    }
+#if SPEED_LOOP
+    Speed_Command(command);
+    Speed_Update();
+#else
+    Motor_Command(command);
+#endif
+    PROFILE_END(PROFILE_MOTOR);
+}
+
+// Send what the controller saw and commanded this tick. Once a
+// lap is planned, one map segment follows each record until the
+// whole map is out: index in time, speed in raw, hard in bump,
+// position/4 and turn in position and leftDuty, steps and steer
+// in rightDuty.
+void Log_Task(void){
+    Telemetry_Record_t r;
+    const TrackMap_Segment_t *seg;
+    r.state = Fsm.state;
+    r.raw = Fsm.data;
+    r.bump = Bump_Read();
+    r.time = Clock_Micros();
+    r.position = Fsm.position;
+    r.leftDuty = MOTOR_CMD_LEFT(Fsm.command);
+    r.rightDuty = MOTOR_CMD_RIGHT(Fsm.command);
+    Telemetry_Log(&r);
+    if(Map.phase != TRACKMAP_RACE){
+        Exported = 0;
+    }else if(Exported < Map.count){
+        seg = &Map.segment[Exported];
+        r.state = TRACKMAP_RECORD;
+        r.raw = seg->speed;
+        r.bump = seg->hard;
+        r.time = Exported;
+        r.position = seg->position;
+        r.leftDuty = (uint16_t)seg->turn;
+        r.rightDuty = seg->steps | ((uint8_t)seg->steer<<8);
+        Telemetry_Log(&r);
+        Exported++;
     }
-    return 0;
 }
 
+// Spin on the spot so every sensor sweeps over the floor and
+// the line, measuring the discharge times every 5 ms. A good
+// result replaces the stored profile; a bad one (no line under
+// the robot) leaves Cal as it was.
+static void Calibrate(void){
+    uint32_t i;
+    Calibrate_Begin();
+    Motor_Command(MOTOR_CMD(MOTOR_DIR_RIGHT, CAL_DUTY, CAL_DUTY));
+    for(i = 0; i < CAL_SAMPLES; i++){
+        Calibrate_Sample();
+        Clock_Delay1ms(5);
+    }
+    Motor_Stop();
+    if(Calibrate_End(&Cal)){
+        Calibrate_Save(&Cal);
+    }
+}
 
 void main(void){
-    // write this as a robot challenge
-    uint16_t L_Motor;
-    uint16_t R_Motor;
-    //int32_t Output;
-    uint8_t Data;
-    int32_t Dist;
-    uint8_t NS;
-
-    Clock_Init48MHz();
+    uint32_t ran, woke = 0;        // woke: back from LPM3, no tick run since
+    Boot_Mark(BOOT_MAIN);
+    Ram_Init();                    // vector table to SRAM before any interrupt
+    Clock_Begin48MHz();            // 12 MHz DCO now, crystal settles during the inits
+    Boot_Mark(BOOT_CLOCK);
+    Profile_Init();
     Motor_Init();
+    Battery_Init();                // conversions on TIMER_A0, started by Motor_Init
+    Speed_Init();
     BumpInt_Init();
     Reflectance_Init();
-    Spt = L_Center;
+    Telemetry_Init();
+    Param_Init(Params, sizeof(Params)/sizeof(Params[0]));
+    Power_Init();
+    FSM_SetHooks(L_Lost, 0, &LostExit);
+    FSM_SetHooks(R_Lost, 0, &LostExit);
+    FSM_SetHooks(Stop, &StopEntry, 0);
+    FSM_Init(&Fsm, L_Center);
+    Curve_Init(&Ahead);
+    TrackMap_Init(&Map);
+    PID_Init(&Steer, PID_KP, PID_KI, PID_KD, PID_IMAX, FX_DUTY_MAX);
+    Boot_Mark(BOOT_PERIPH);
+    if(Clock_Finish48MHz() && Clock_Finish48MHz()){  // usually no crystal wait left by now
+        FSM_Enter(&Fsm, Stop);     // no crystal: stay parked rather than race at 12 MHz
+    }
+    Boot_Mark(BOOT_HFXT);
+    if(!Calibrate_Load(&Cal) || Bump_Read()){
+        Calibrate();               // no profile yet, or a bumper held at reset
+    }
 
+    Scheduler_Init(TICK_RATE);
+    Scheduler_AddTask(&Param_Task, PARAM_PERIOD);  // first, so a commit lands between ticks
+    Scheduler_AddTask(&FSM_Task, FSM_PERIOD);
+    Scheduler_AddTask(&Motor_Task, MOTOR_PERIOD);
+    Scheduler_AddTask(&Log_Task, LOG_PERIOD);
+    Scheduler_AddTask(&BumpInt_Tick, BUMP_PERIOD);
+    Scheduler_AddTask(&Reflectance_Adapt, ADAPT_PERIOD);
+    Scheduler_AddTask(&Supervisor_Task, SUPERVISOR_PERIOD);  // after every other task
+    Reflectance_Async_Init(Cal.time + SAMPLE_SLACK, Cal.time);
+    Reflectance_SetLimits(Cal.minTime, Cal.maxTime);
+    Supervisor_Init();             // watchdog armed from here on
+    Scheduler_Start();
+    Boot_Mark(BOOT_START);
 
     while(1){
-        L_Motor = Spt->L_Duty;            // set output from FSM
-        R_Motor = Spt->R_Duty;            // set output from FSM
-        if(Spt->function == 1){
-            Motor_Right(L_Motor,R_Motor);
-        }
-        else if(Spt->function == 2){
-            Motor_Left(L_Motor,R_Motor);
-        }
-        else{
-            Motor_Forward(L_Motor,R_Motor);
+        PROFILE_BEGIN(PROFILE_TICK);
+        ran = Scheduler_Run();
+        if(ran){
+            PROFILE_END(PROFILE_TICK);
+            woke = 0;
+        }else if(!woke && (Fsm.state == Stop) && (Fsm.dwell == 0) && !Telemetry_Busy()){
+            Motor_Stop();          // parked: drivers off, then LPM3 until the RTC
+            if(Clock_GetFreq() != 12000000){
+                Clock_SetProfile(CLOCK_12MHZ);  // nothing left to race for
+                Scheduler_Retime();
+            }
+            Supervisor_Park();     // no ticks in LPM3
+            Power_Deep();
+            woke = 1;              // SysTick was frozen: idle until it runs a tick
+        }else{
+            Power_Idle();          // LPM0 until the next tick
         }
-        Clock_Delay1ms(Spt->delay);   // wait
-        Data = Reflectance_Read(1000);
-        Dist = Reflectance_Position(Data);    // read sensors
-        NS = nextStateIDX(Dist, Data);
-
-        Spt = Spt->next[NS];       // next depends on input and state
-
-  }
-
+    }
 }
@@ -48,9 +48,27 @@ policies, either expressed or implied, of the FreeBSD Project.
 
 #include <stdint.h>
 #include "msp.h"
+#include "Priority.h"
+#include "Motor.h"
+#include "FixedPoint.h"
+#include "Battery.h"
+#include "Ram.h"
 
 // *******Lab 13 solution*******
 
+// Commands are double buffered: Motor_Command only stores the
+// new word in Pending. Once per PWM period the TIMER_A0 CCR0 ISR
+// moves each wheel's actual duty toward its target by at most
+// Slew, then latches direction and CCR3/CCR4 at the top of the
+// up-down count, where both toggle/reset outputs are low.
+// Duties are kept signed (negative is backward) so a reversal
+// ramps down, holds 0 for one period, then ramps up the other way.
+#define ASLEEP 0xFFFFFFFF                  // drivers in sleep, never a valid command
+static volatile uint32_t Pending = ASLEEP; // last requested command
+static uint32_t Current = ASLEEP;          // command in the hardware
+static int32_t LeftNow = 0, RightNow = 0;  // actual signed duties
+static volatile uint32_t Slew = MOTOR_SLEW_DEFAULT; // max duty change per period, 0 = no limit
+
 // ------------Motor_Init------------
 // Initialize GPIO pins for output, which will be
 // used to control the direction of the motors and
@@ -66,7 +84,11 @@ void Motor_Init(void){
     P2->SEL0 |= 0xC0;
     P2->SEL1 &= ~0xC0;
     P2->DIR |= 0xC0;
-    TIMER_A0->CCTL[0] = 0x0080; // CCI0 toggle
+    Pending = ASLEEP;
+    Current = ASLEEP;
+    LeftNow = RightNow = 0;
+    Slew = MOTOR_SLEW_DEFAULT;
+    TIMER_A0->CCTL[0] = 0x0090; // CCI0 toggle, interrupt at the top of each period
     TIMER_A0->CCR[0] = 15000; // Period is 10ms
     TIMER_A0->EX0 = 0x0000; // divide by 1
     TIMER_A0->CCTL[3] = 0x0040; // Right motor toggle/reset
@@ -97,7 +119,8 @@ void Motor_Init(void){
     P5->DIR |= 0x30;
     P5->OUT &= ~0x30;
 
-
+    NVIC_SetPriority(TA0_0_IRQn, PRIORITY_PWM);
+    NVIC_EnableIRQ(TA0_0_IRQn);
 }
 
 // ------------Motor_Stop------------
@@ -105,12 +128,95 @@ void Motor_Init(void){
 // set the PWM speed control to 0% duty cycle.
 // Input: none
 // Output: none
+// Takes effect immediately, not at the next period.
 void Motor_Stop(void){
+    Pending = ASLEEP;     // discard any command not yet latched
     P3->OUT &= ~0xC0; // Sleep
     TIMER_A0->CCR[3] = 0; // Right motor duty cycle is 0
     TIMER_A0->CCR[4] = 0; // Left motor duty cycle is 0
+    LeftNow = RightNow = 0;
+    Current = ASLEEP;
+}
+
+// ------------TA0_0_IRQHandler------------
+// Top of the PWM period (TAR = CCR0), both outputs are low.
+// Scale the pending command to the battery voltage, ramp both
+// wheels toward it (slower while the battery sags) and latch
+// the result if it differs from what is already in the hardware.
+RAMFUNC void TA0_0_IRQHandler(void){
+    uint32_t command, dir;
+    int32_t left, right, slew;
+    q16_t scale;
+    TIMER_A0->CCTL[0] &= ~0x0001;  // acknowledge CCR0
+    command = Pending;
+    if(command == ASLEEP){
+        if(Current != ASLEEP){
+            Motor_Stop();
+        }
+        return;
+    }
+    scale = Battery_Scale();
+    left = FX_ClampDuty(FX_MulQ16(scale, MOTOR_CMD_LEFT(command)));
+    right = FX_ClampDuty(FX_MulQ16(scale, MOTOR_CMD_RIGHT(command)));
+    if(command&0x10000000) left = -left;    // P5.4, left backward
+    if(command&0x20000000) right = -right;  // P5.5, right backward
+    slew = Slew;
+    if(Battery_Low() && ((slew == 0) || (slew > MOTOR_SLEW_LOW))){
+        slew = MOTOR_SLEW_LOW;      // smaller current steps near a brown-out
+    }
+    LeftNow = Motor_Ramp(LeftNow, left, slew);
+    RightNow = Motor_Ramp(RightNow, right, slew);
+    dir = ((LeftNow < 0)? 0x10 : 0) | ((RightNow < 0)? 0x20 : 0);
+    command = MOTOR_CMD(dir, (LeftNow < 0)? -LeftNow : LeftNow,
+                             (RightNow < 0)? -RightNow : RightNow);
+    if(command == Current){
+        return;                    // unchanged, no register writes
+    }
+    BITBAND_PERI(P5->OUT, 4) = (command>>28)&1; // left direction
+    BITBAND_PERI(P5->OUT, 5) = (command>>29)&1; // right direction
+    TIMER_A0->CCR[3] = MOTOR_CMD_RIGHT(command); // Right motor duty cycle
+    TIMER_A0->CCR[4] = MOTOR_CMD_LEFT(command);  // Left motor duty cycle
+    if(Current == ASLEEP){
+        P3->OUT |= 0xC0;           // No sleep
+    }
+    Current = command;
+}
+
+// ------------Motor_NearEdge------------
+// In up/down mode each output switches when TAR passes its
+// CCR, going up and coming down. A duty of 0 never switches.
+// Input: none
+// Output: 1 if TAR is within MOTOR_EDGE_GUARD of CCR3 or CCR4
+RAMFUNC int Motor_NearEdge(void){
+    int32_t now = TIMER_A0->R, edge, i;
+    for(i = 3; i <= 4; i++){
+        edge = TIMER_A0->CCR[i];
+        if(edge && ((now - edge) < MOTOR_EDGE_GUARD) && ((edge - now) < MOTOR_EDGE_GUARD)){
+            return 1;
+        }
+    }
+    return 0;
+}
 
+// ------------Motor_SetSlew------------
+// Set the largest change in duty per PWM period (20 ms).
+// Input: slew  duty change per period, 0 to apply commands at once
+// Output: none
+void Motor_SetSlew(uint16_t slew){
+    Slew = slew;
+}
 
+// ------------Motor_Command------------
+// Request a new direction and duty cycles, packed with
+// MOTOR_CMD(). TA0_0_IRQHandler ramps the wheels toward
+// it at up to Slew per PWM period and latches each step
+// at a period boundary, so the outputs never see a partial
+// update. Repeating the same command costs one store.
+// Input: command  direction and duty cycles
+// Output: none
+// Assumes: Motor_Init() has been called
+void Motor_Command(uint32_t command){
+    Pending = command;
 }
 
 // ------------Motor_Forward------------
@@ -122,10 +228,7 @@ void Motor_Stop(void){
 // Output: none
 // Assumes: Motor_Init() has been called
 void Motor_Forward(uint16_t leftDuty, uint16_t rightDuty){
-    P3->OUT |= 0xC0; // No sleep
-    P5->OUT &= ~0x30;   // forward direction
-    TIMER_A0->CCR[3] = rightDuty; // Right motor duty cycle is 0
-    TIMER_A0->CCR[4] = leftDuty; // Left motor duty cycle is 0
+    Motor_Command(MOTOR_CMD(MOTOR_DIR_FORWARD, leftDuty, rightDuty));
 }
 
 // ------------Motor_Right------------
@@ -137,11 +240,7 @@ void Motor_Forward(uint16_t leftDuty, uint16_t rightDuty){
 // Output: none
 // Assumes: Motor_Init() has been called
 void Motor_Right(uint16_t leftDuty, uint16_t rightDuty){
-    P3->OUT |= 0xC0; // No sleep
-    P5->OUT |= 0x20;   // left wheel forward direction
-    P5->OUT &= ~0x10;   // right wheel backward direction
-    TIMER_A0->CCR[3] = rightDuty; // Right motor duty cycle is 0
-    TIMER_A0->CCR[4] = leftDuty; // Left motor duty cycle is 0
+    Motor_Command(MOTOR_CMD(MOTOR_DIR_RIGHT, leftDuty, rightDuty));
 }
 
 // ------------Motor_Left------------
@@ -153,11 +252,7 @@ void Motor_Right(uint16_t leftDuty, uint16_t rightDuty){
 // Output: none
 // Assumes: Motor_Init() has been called
 void Motor_Left(uint16_t leftDuty, uint16_t rightDuty){
-    P3->OUT |= 0xC0; // No sleep
-    P5->OUT &= ~0x20;   // left wheel backward direction
-    P5->OUT |= 0x10;   // right wheel forward direction
-    TIMER_A0->CCR[3] = rightDuty; // Right motor duty cycle is 0
-    TIMER_A0->CCR[4] = leftDuty; // Left motor duty cycle is 0  // write this as part of Lab 13
+    Motor_Command(MOTOR_CMD(MOTOR_DIR_LEFT, leftDuty, rightDuty));
 }
 
 // ------------Motor_Backward------------
@@ -169,8 +264,5 @@ void Motor_Left(uint16_t leftDuty, uint16_t rightDuty){
 // Output: none
 // Assumes: Motor_Init() has been called
 void Motor_Backward(uint16_t leftDuty, uint16_t rightDuty){
-    P3->OUT |= 0xC0; // No sleep
-    P5->OUT |= 0x30;   // backward direction
-    TIMER_A0->CCR[3] = rightDuty; // Right motor duty cycle is 0
-    TIMER_A0->CCR[4] = leftDuty; // Left motor duty cycle is 0  // write this as part of Lab 13
+    Motor_Command(MOTOR_CMD(MOTOR_DIR_BACKWARD, leftDuty, rightDuty));
 }
@@ -64,9 +64,64 @@ policies, either expressed or implied, of the FreeBSD Project.
 
 #ifndef MOTOR_H_
 #define MOTOR_H_
+#include <stdint.h>
+#include "FixedPoint.h"
 
 // *******Lab 13 solution*******
 
+/**
+ * \brief Direction bits for P5.5 (right) and P5.4 (left), 1 means backward
+ */
+#define MOTOR_DIR_FORWARD  0x00
+#define MOTOR_DIR_RIGHT    0x20  // left forward, right backward
+#define MOTOR_DIR_LEFT     0x10  // left backward, right forward
+#define MOTOR_DIR_BACKWARD 0x30
+
+/**
+ * \brief Pack a direction and two duty cycles into one motor command word
+ * bits 29-28 P5.5-P5.4 direction, bits 27-14 left duty, bits 13-0 right duty
+ */
+#define MOTOR_CMD(dir, leftDuty, rightDuty) \
+  ((((uint32_t)(dir))<<24)|(((uint32_t)(leftDuty))<<14)|((uint32_t)(rightDuty)))
+#define MOTOR_CMD_DIR(cmd)   (((cmd)>>24)&0x30)    // direction bits of a command
+#define MOTOR_CMD_LEFT(cmd)  (((cmd)>>14)&0x3FFF)  // left duty of a command
+#define MOTOR_CMD_RIGHT(cmd) ((cmd)&0x3FFF)        // right duty of a command
+#define MOTOR_CMD_LEFT_SIGNED(cmd)  (((cmd)&0x10000000)? -(int32_t)MOTOR_CMD_LEFT(cmd) : (int32_t)MOTOR_CMD_LEFT(cmd))
+#define MOTOR_CMD_RIGHT_SIGNED(cmd) (((cmd)&0x20000000)? -(int32_t)MOTOR_CMD_RIGHT(cmd) : (int32_t)MOTOR_CMD_RIGHT(cmd))
+
+/**
+ * \brief Default largest duty change per 20 ms PWM period, 0 to 7000 in 100 ms
+ */
+#define MOTOR_SLEW_DEFAULT 1500
+
+/**
+ * \brief Largest duty change per PWM period while Battery_Low(), 0 to 7000 in 500 ms
+ */
+#define MOTOR_SLEW_LOW 300
+
+/**
+ * Move a signed duty one step toward its target, the ramp that
+ * TA0_0_IRQHandler applies once per PWM period. Hardware independent,
+ * so the host simulator runs the same ramp.
+ * @param now signed duty in the hardware, negative is backward
+ * @param target signed duty commanded
+ * @param slew largest change, 0 for no limit
+ * @return next signed duty; never crosses zero in a single step
+ * @brief  One ramp step
+ */
+static inline int32_t Motor_Ramp(int32_t now, int32_t target, int32_t slew){
+    int32_t next;
+    if(slew == 0){
+        next = target;
+    }else{
+        next = now + FX_Clamp(target - now, -slew, slew);
+    }
+    if(((now > 0) && (next < 0)) || ((now < 0) && (next > 0))){
+        next = 0;                   // stop for one period before reversing
+    }
+    return next;
+}
+
 /**
  * Initialize GPIO pins for output, which will be
  * used to control the direction of the motors and
@@ -83,12 +138,60 @@ void Motor_Init(void);
 /**
  * Stop the motors, power down the drivers, and
  * set the PWM speed control to 0% duty cycle.
+ * Unlike the other commands this takes effect immediately
+ * and discards any command that has not been latched yet.
  * @param none
  * @return none
  * @brief  Stop the robot
  */
 void Motor_Stop(void);
 
+/**
+ * \brief TIMER_A0 counts (1.5 MHz) either side of a PWM edge that Motor_NearEdge() reports
+ */
+#define MOTOR_EDGE_GUARD 15
+
+/**
+ * Check whether a PWM output is switching about now.
+ * The H-bridges couple noise into the sensor lines at every
+ * edge, so the reflectance engine moves a read that would
+ * land within MOTOR_EDGE_GUARD counts of one.
+ * @param none
+ * @return 1 if TIMER_A0 is near the CCR3 or CCR4 compare point, 0 if not
+ * @note Safe to call from any ISR, reads only
+ * @brief  Check for a PWM switching edge
+ */
+int Motor_NearEdge(void);
+
+/**
+ * Drive both wheels from a pre-encoded command word
+ * built with MOTOR_CMD(). Forward, Right, Left and
+ * Backward are all special cases of this function.
+ * The TIMER_A0 CCR0 interrupt ramps each wheel toward the command by
+ * at most the slew rate per PWM period (20 ms) and latches each step
+ * at the period boundary, so direction and both duties change together
+ * while the outputs are low. A wheel that reverses ramps down to 0,
+ * holds 0 for one period, then ramps up in the new direction.
+ * Both duties are scaled by Battery_Scale() first, so a duty gives the
+ * same motor voltage as the pack drains, and the slew rate is at most
+ * MOTOR_SLEW_LOW while Battery_Low().
+ * Repeating the current command does not touch any registers.
+ * @param command direction and duty cycles packed by MOTOR_CMD()
+ * @return none
+ * @note Assumes Motor_Init() has been called
+ * @brief  Drive the robot from a command word
+ */
+void Motor_Command(uint32_t command);
+
+/**
+ * Set the slew rate used by Motor_Command().
+ * @param slew largest duty change per 20 ms PWM period, 0 for no limit
+ * @return none
+ * @note Motor_Init() sets MOTOR_SLEW_DEFAULT
+ * @brief  Set the motor ramp rate
+ */
+void Motor_SetSlew(uint16_t slew);
+
 /**
  * Drive the robot forward by running left and
  * right wheels forward with the given duty
@@ -0,0 +1,67 @@
+// PID.c
+// Runs on MSP432
+// Fixed-point PID controller with anti-windup.
+// Gains are Q16; the three terms are formed with FX_MulSatQ16
+// and summed with saturating adds, so large gains clip rather
+// than wrap. About 35 cycles per update.
+// Team Donkey Kong
+
+#include <stdint.h>
+#include "FixedPoint.h"
+#include "PID.h"
+#include "Ram.h"
+
+// ------------PID_Init------------
+// Set gains and limits and clear the state.
+// Input: pid          controller
+//        kp, ki, kd   gains in Q16
+//        integralMax  clamp on the accumulated error
+//        outMax       clamp on the output magnitude
+// Output: none
+void PID_Init(PID_t *pid, int32_t kp, int32_t ki, int32_t kd,
+              int32_t integralMax, int32_t outMax){
+  pid->Kp = kp;
+  pid->Ki = ki;
+  pid->Kd = kd;
+  pid->integralMax = integralMax;
+  pid->outMax = outMax;
+  PID_Reset(pid);
+}
+
+// ------------PID_Reset------------
+// Clear the integrator and derivative history.
+// Input: pid  controller
+// Output: none
+void PID_Reset(PID_t *pid){
+  pid->integral = 0;
+  pid->last = 0;
+}
+
+// ------------PID_Update------------
+// One controller update.
+// Input: pid    controller
+//        error  setpoint minus measurement
+// Output: control output, clamped to +/-outMax
+RAMFUNC int32_t PID_Update(PID_t *pid, int32_t error){
+  int32_t integral, out;
+
+  integral = FX_Clamp(FX_SatAdd(pid->integral, error), -pid->integralMax, pid->integralMax);
+  out = FX_SatAdd(FX_SatAdd(FX_MulSatQ16(pid->Kp, error),
+                            FX_MulSatQ16(pid->Ki, integral)),
+                  FX_MulSatQ16(pid->Kd, FX_SatSub(error, pid->last)));
+  pid->last = error;
+  if(out > pid->outMax){
+    out = pid->outMax;
+    if(error > 0){
+      return out;                 // saturated high, do not wind up further
+    }
+  }
+  else if(out < -pid->outMax){
+    out = -pid->outMax;
+    if(error < 0){
+      return out;                 // saturated low, do not wind up further
+    }
+  }
+  pid->integral = integral;
+  return out;
+}
@@ -0,0 +1,68 @@
+/**
+ * @file      PID.h
+ * @brief     Fixed-point PID controller
+ * @details   Discrete PID controller with Q16 gains (65536 means 1.0)
+ * built on FixedPoint.h,
+ * a clamped integrator and conditional integration for anti-windup.
+ * The integrator only accumulates while the output is not saturated
+ * in the direction of the error, so the output recovers as soon as the
+ * error changes sign.
+ * @author    Team Donkey Kong
+ ******************************************************************************/
+
+/*!
+ * @defgroup RSLK_Control
+ * @brief
+ * @{*/
+#ifndef PID_H_
+#define PID_H_
+#include <stdint.h>
+
+/**
+ * \brief State and gains of one PID controller
+ */
+struct PID {
+  int32_t Kp;           // proportional gain, Q16
+  int32_t Ki;           // integral gain per update, Q16
+  int32_t Kd;           // derivative gain per update, Q16
+  int32_t integral;     // sum of error
+  int32_t integralMax;  // integrator clamp, |integral| <= integralMax
+  int32_t outMax;       // output clamp, |output| <= outMax
+  int32_t last;         // error at the previous update
+};
+typedef struct PID PID_t;
+
+/**
+ * Set the gains and limits of a controller and clear its state.
+ * @param  pid controller to initialize
+ * @param  kp proportional gain, Q16
+ * @param  ki integral gain, Q16
+ * @param  kd derivative gain, Q16
+ * @param  integralMax clamp on the accumulated error
+ * @param  outMax clamp on the output magnitude
+ * @return none
+ * @brief  Initialize a PID controller
+ */
+void PID_Init(PID_t *pid, int32_t kp, int32_t ki, int32_t kd,
+              int32_t integralMax, int32_t outMax);
+
+/**
+ * Clear the integrator and derivative history, keeping the gains.
+ * Call when the controller takes over from another mode.
+ * @param  pid controller to reset
+ * @return none
+ * @brief  Reset a PID controller
+ */
+void PID_Reset(PID_t *pid);
+
+/**
+ * Run one update of the controller.
+ * @param  pid controller to update
+ * @param  error setpoint minus measurement
+ * @return control output, -outMax to +outMax
+ * @note   Call at a fixed rate; Ki and Kd are per update, not per second
+ * @brief  Run one PID update
+ */
+int32_t PID_Update(PID_t *pid, int32_t error);
+
+#endif /* PID_H_ */
@@ -0,0 +1,216 @@
+// Param.c
+// Runs on MSP432
+// Parameter registry: staged sets from UART0 (eUSCI_A0,
+// P1.2 RX) committed together at a tick boundary, replies
+// sent as telemetry records.
+// The RX ISR only writes RxHead, Param_Task() only RxTail.
+// Team Donkey Kong
+
+#include <stdint.h>
+#include "msp.h"
+#include "Priority.h"
+#include "Motor.h"
+#include "Telemetry.h"
+#include "Param.h"
+
+#define RX_MASK (PARAM_RX_SIZE-1)
+#define DUTY_MASK 0x3FFF
+
+static const Param_t *Table;
+static uint32_t Count;
+static int32_t Staged[PARAM_MAX];        // values waiting for PARAM_COMMIT
+static uint32_t Dirty[(PARAM_MAX+31)/32]; // 1 bit per staged ID
+
+static uint8_t Rx[PARAM_RX_SIZE];
+static volatile uint32_t RxHead = 0;     // next byte to write, ISR only
+static volatile uint32_t RxTail = 0;     // next byte to read, Param_Task only
+static volatile uint8_t RxLost = 0;      // bytes dropped by the ISR
+static uint8_t Frame[PARAM_FRAME];
+static uint32_t Length = 0;              // bytes of Frame collected
+
+// Value stored at a registry entry
+static int32_t Read(const Param_t *p){
+  switch(p->type){
+  case PARAM_UINT16:     return *(uint16_t *)p->value;
+  case PARAM_DUTY_LEFT:  return MOTOR_CMD_LEFT(*(uint32_t *)p->value);
+  case PARAM_DUTY_RIGHT: return MOTOR_CMD_RIGHT(*(uint32_t *)p->value);
+  default:               return *(int32_t *)p->value;
+  }
+}
+
+// Store a value that is already known to be in range
+static void Write(const Param_t *p, int32_t value){
+  uint32_t *word = (uint32_t *)p->value;
+  switch(p->type){
+  case PARAM_UINT16:
+    *(uint16_t *)p->value = (uint16_t)value;
+    break;
+  case PARAM_DUTY_LEFT:
+    *word = (*word&~(DUTY_MASK<<14))|(((uint32_t)value&DUTY_MASK)<<14);
+    break;
+  case PARAM_DUTY_RIGHT:
+    *word = (*word&~DUTY_MASK)|((uint32_t)value&DUTY_MASK);
+    break;
+  default:
+    *(int32_t *)p->value = value;
+    break;
+  }
+}
+
+// Copy every staged value to RAM, then run the hooks
+static uint32_t Commit(void){
+  uint32_t id, n = 0;
+  int32_t old;
+  for(id = 0; id < Count; id++){
+    if(Dirty[id/32]&(1u<<(id%32))){
+      Dirty[id/32] &= ~(1u<<(id%32));
+      old = Read(&Table[id]);
+      Write(&Table[id], Staged[id]);
+      if(Table[id].changed && (old != Staged[id])){
+        Table[id].changed(Staged[id]);
+      }
+      n++;
+    }
+  }
+  return n;
+}
+
+// Queue a reply record
+static void Reply(uint8_t command, uint8_t status, uint32_t id, int32_t value){
+  Telemetry_Record_t r;
+  r.state = PARAM_RECORD;
+  r.raw = command;
+  r.bump = status;
+  r.time = id;
+  r.position = value;
+  r.leftDuty = (id < Count)? Table[id].type : 0;
+  r.rightDuty = Count;
+  if((command == PARAM_INFO) && (status == PARAM_OK)){
+    r.leftDuty = (uint16_t)Table[id].max;
+    r.rightDuty = (uint16_t)((uint32_t)Table[id].max>>16);
+  }
+  Telemetry_Log(&r);
+}
+
+// Run one complete frame
+static void Execute(const uint8_t *f){
+  uint8_t command = f[1], id = f[2];
+  int32_t value = (int32_t)((uint32_t)f[3]|((uint32_t)f[4]<<8)|((uint32_t)f[5]<<16)|((uint32_t)f[6]<<24));
+  const Param_t *p;
+  if((f[1]^f[2]^f[3]^f[4]^f[5]^f[6]) != f[7]){
+    Reply(command, PARAM_BAD_FRAME, id, 0);
+    return;
+  }
+  if(command == PARAM_COMMIT){
+    Reply(command, PARAM_OK, id, Commit());
+    return;
+  }
+  if(id >= Count){
+    Reply(command, PARAM_BAD_ID, id, 0);
+    return;
+  }
+  p = &Table[id];
+  switch(command){
+  case PARAM_GET:
+    Reply(command, PARAM_OK, id, Read(p));
+    break;
+  case PARAM_DEFAULT:
+    value = p->deflt;                  // then stage it like a set, fall through
+  case PARAM_SET:
+    if((value < p->min) || (value > p->max)){
+      Reply(command, PARAM_RANGE, id, value);
+      break;
+    }
+    Staged[id] = value;
+    Dirty[id/32] |= 1u<<(id%32);
+    Reply(command, PARAM_OK, id, value);
+    break;
+  case PARAM_INFO:
+    Reply(command, PARAM_OK, id, p->min);
+    break;
+  default:
+    Reply(command, PARAM_BAD_FRAME, id, 0);
+    break;
+  }
+}
+
+// ------------Param_Init------------
+// Take a registry, load the defaults and enable the UART
+// receive interrupt.
+// Input: table  registry, index is the ID
+//        count  entries, at most PARAM_MAX
+// Output: none
+// Assumes: Telemetry_Init() has set up eUSCI_A0
+void Param_Init(const Param_t *table, uint32_t count){
+  uint32_t i;
+  Table = table;
+  Count = (count > PARAM_MAX)? PARAM_MAX : count;
+  for(i = 0; i < Count; i++){
+    Write(&Table[i], Table[i].deflt);
+  }
+  for(i = 0; i < (PARAM_MAX+31)/32; i++){
+    Dirty[i] = 0;
+  }
+  RxHead = RxTail = 0;
+  RxLost = 0;
+  Length = 0;
+  EUSCI_A0->IFG &= ~0x0001;            // drop anything received before now
+  EUSCI_A0->IE |= 0x0001;              // RX interrupt only, the DMA owns TXIFG
+  NVIC_SetPriority(EUSCIA0_IRQn, PRIORITY_COMMAND);
+  NVIC_EnableIRQ(EUSCIA0_IRQn);
+}
+
+// One byte received, or an overrun
+void EUSCIA0_IRQHandler(void){
+  uint32_t head = RxHead, next = (head + 1)&RX_MASK;
+  uint8_t data;
+  if(EUSCI_A0->STATW&0x0020){
+    RxLost = 1;                        // overrun, a byte was lost in the USCI
+  }
+  data = EUSCI_A0->RXBUF;              // clears RXIFG and the overrun flag
+  if(next == RxTail){
+    RxLost = 1;                        // ring full
+    return;
+  }
+  Rx[head] = data;
+  RxHead = next;
+}
+
+// ------------Param_Get------------
+// Read the RAM value of a parameter.
+// Input: id  parameter ID
+// Output: value, 0 for an unknown ID
+int32_t Param_Get(uint32_t id){
+  if(id >= Count){
+    return 0;
+  }
+  return Read(&Table[id]);
+}
+
+// ------------Param_Task------------
+// Collect frames from the receive ring and run them. A frame
+// starts at PARAM_SYNC; lost bytes drop the partial frame.
+// Input: none
+// Output: none
+void Param_Task(void){
+  uint32_t tail = RxTail, head = RxHead;
+  uint8_t data;
+  if(RxLost){
+    RxLost = 0;
+    Length = 0;
+    Reply(0, PARAM_OVERRUN, 0, 0);
+  }
+  while(tail != head){
+    data = Rx[tail];
+    tail = (tail + 1)&RX_MASK;
+    if((Length == 0) && (data != PARAM_SYNC)){
+      continue;                        // hunt for the start of a frame
+    }
+    Frame[Length++] = data;
+    if(Length == PARAM_FRAME){
+      Length = 0;
+      Execute(Frame);
+    }
+  }
+  RxTail = tail;
+}
@@ -0,0 +1,123 @@
+/**
+ * @file      Param.h
+ * @brief     Registry of runtime-tunable parameters and its UART protocol
+ * @details   Each parameter has an ID (its index in the registry), a type,
+ * a range, a RAM value the control code reads and a default kept with
+ * the registry in flash. A host changes them over the telemetry UART
+ * (eUSCI_A0, P1.2 RX) with fixed 8-byte frames, little endian:
+<table>
+<caption id="param_frame">Command frame</caption>
+<tr><th>Offset<th>Size<th>Field
+<tr><td>0 <td>1<td>PARAM_SYNC
+<tr><td>1 <td>1<td>command, enum Param_Command
+<tr><td>2 <td>1<td>parameter ID
+<tr><td>3 <td>4<td>value (PARAM_SET only)
+<tr><td>7 <td>1<td>checksum, XOR of bytes 1-6
+</table>
+ * A set only stages the value. PARAM_COMMIT copies every staged value
+ * at once, from Param_Task(), which runs first in the tick, so every
+ * control task of a tick sees either all old or all new values.<br>
+ * Every frame is answered with one Telemetry_Record_t in the normal
+ * stream, with state PARAM_RECORD:
+<table>
+<caption id="param_reply">Reply record</caption>
+<tr><th>Field   <th>Contents
+<tr><td>raw     <td>command
+<tr><td>bump    <td>enum Param_Status
+<tr><td>time    <td>parameter ID
+<tr><td>position<td>value: RAM (GET), staged (SET), default (DEFAULT), minimum (INFO), values copied (COMMIT)
+<tr><td>leftDuty<td>type, or the low half of the maximum (INFO)
+<tr><td>rightDuty<td>parameter count, or the high half of the maximum (INFO)
+</table>
+ * @author    Team Donkey Kong
+ * @note      Param_Init() after Telemetry_Init(), which sets up the UART
+ ******************************************************************************/
+
+/*!
+ * @defgroup RSLK_Input_Output
+ * @brief
+ * @{*/
+#ifndef PARAM_H_
+#define PARAM_H_
+#include <stdint.h>
+
+#define PARAM_SYNC    0x5A  // first byte of every command frame
+#define PARAM_FRAME   8     // bytes in a command frame
+#define PARAM_RECORD  0xFD  // Telemetry_Record_t state of a reply
+#define PARAM_MAX     64    // largest registry
+#define PARAM_RX_SIZE 64    // receive ring in bytes, power of 2
+
+/**
+ * \brief How a parameter is stored in RAM
+ */
+enum Param_Type {
+  PARAM_INT32,       // int32_t
+  PARAM_UINT16,      // uint16_t
+  PARAM_DUTY_LEFT,   // left duty field of a MOTOR_CMD() word
+  PARAM_DUTY_RIGHT   // right duty field of a MOTOR_CMD() word
+};
+
+/**
+ * \brief Command byte of a frame
+ */
+enum Param_Command {
+  PARAM_GET = 'G',     // read the RAM value
+  PARAM_SET = 'S',     // stage a value
+  PARAM_COMMIT = 'C',  // copy every staged value, ID ignored
+  PARAM_DEFAULT = 'D', // stage the default
+  PARAM_INFO = 'I'     // read the range
+};
+
+/**
+ * \brief Status byte of a reply
+ */
+enum Param_Status {
+  PARAM_OK,
+  PARAM_BAD_ID,        // no parameter with this ID
+  PARAM_RANGE,         // value outside min..max, not staged
+  PARAM_BAD_FRAME,     // checksum or command wrong
+  PARAM_OVERRUN        // receive ring overflowed, bytes lost
+};
+
+/**
+ * \brief One registry entry, kept in flash
+ */
+struct Param {
+  void *value;                    // RAM copy the control code reads
+  int32_t min;                    // smallest accepted value
+  int32_t max;                    // largest accepted value
+  int32_t deflt;                  // value at reset
+  uint8_t type;                   // enum Param_Type
+  void (*changed)(int32_t value); // called after a commit changed it, or 0
+};
+typedef struct Param Param_t;
+
+/**
+ * Take a registry, write every default to RAM and enable the
+ * UART receive interrupt.
+ * @param  table registry, index is the ID
+ * @param  count entries, at most PARAM_MAX
+ * @return none
+ * @note   The changed() hooks are not called for the defaults
+ * @brief  Initialize the parameter store
+ */
+void Param_Init(const Param_t *table, uint32_t count);
+
+/**
+ * Read the RAM value of a parameter.
+ * @param  id parameter ID
+ * @return value, 0 for an unknown ID
+ * @brief  Get a parameter
+ */
+int32_t Param_Get(uint32_t id);
+
+/**
+ * Parse the bytes received since the last call and answer each
+ * frame. Run as the first periodic task of every tick.
+ * @param  none
+ * @return none
+ * @brief  Serve the parameter protocol
+ */
+void Param_Task(void);
+
+#endif /* PARAM_H_ */
@@ -0,0 +1,57 @@
+// Position.c
+// Runs on MSP432 and on the host (sim/)
+// Line position from the reflectance sensor readings. No
+// register access here, so the FSM and the simulator share it.
+// Team Donkey Kong
+
+#include <stdint.h>
+#include "Reflectance.h"
+
+// Position of the line for every possible 8-bit reading.
+// Entry n is the weighted average of the weights
+//   {-33400,-23800,-14300,-4800,4800,14300,23800,33400}
+// for the bits set in n (bit0 first), using C integer
+// division, which is what the original loop computed.
+// No bits set means no line, so entry 0 is REFLECTANCE_LOST.
+static const int32_t PositionTable[256] = {
+    REFLECTANCE_LOST, -33400, -23800, -28600, -14300, -23850, -19050, -23833, // 0x00-0x07
+     -4800, -19100, -14300, -20666,  -9550, -17500, -14300, -19075, // 0x08-0x0F
+      4800, -14300,  -9500, -17466,  -4750, -14300, -11100, -16675, // 0x10-0x17
+         0, -11133,  -7933, -14300,  -4766, -11925,  -9525, -14300, // 0x18-0x1F
+     14300,  -9550,  -4750, -14300,      0, -11133,  -7933, -14300, // 0x20-0x27
+      4750,  -7966,  -4766, -11925,  -1600,  -9550,  -7150, -12400, // 0x28-0x2F
+      9550,  -4766,  -1566,  -9525,   1600,  -7150,  -4750, -10480, // 0x30-0x37
+      4766,  -4775,  -2375,  -8580,      0,  -6680,  -4760,  -9533, // 0x38-0x3F
+     23800,  -4800,      0, -11133,   4750,  -7966,  -4766, -11925, // 0x40-0x47
+      9500,  -4800,  -1600,  -9550,   1566,  -7175,  -4775, -10500, // 0x48-0x4F
+     14300,  -1600,   1600,  -7150,   4766,  -4775,  -2375,  -8580, // 0x50-0x57
+      7933,  -2400,      0,  -6680,   2375,  -4780,  -2860,  -7950, // 0x58-0x5F
+     19050,   1566,   4766,  -4775,   7933,  -2400,      0,  -6680, // 0x60-0x67
+     11100,    -25,   2375,  -4780,   4750,  -2880,   -960,  -6366, // 0x68-0x6F
+     14300,   2375,   4775,  -2860,   7150,   -960,    960,  -4766, // 0x70-0x77
+      9525,    940,   2860,  -3183,   4760,  -1600,      0,  -4771, // 0x78-0x7F
+     33400,      0,   4800,  -7933,   9550,  -4766,  -1566,  -9525, // 0x80-0x87
+     14300,  -1600,   1600,  -7150,   4766,  -4775,  -2375,  -8580, // 0x88-0x8F
+     19100,   1600,   4800,  -4750,   7966,  -2375,     25,  -6660, // 0x90-0x97
+     11133,      0,   2400,  -4760,   4775,  -2860,   -940,  -6350, // 0x98-0x9F
+     23850,   4766,   7966,  -2375,  11133,      0,   2400,  -4760, // 0xA0-0xA7
+     14300,   2375,   4775,  -2860,   7150,   -960,    960,  -4766, // 0xA8-0xAF
+     17500,   4775,   7175,   -940,   9550,    960,   2880,  -3166, // 0xB0-0xB7
+     11925,   2860,   4780,  -1583,   6680,      0,   1600,  -3400, // 0xB8-0xBF
+     28600,   7933,  11133,      0,  14300,   2375,   4775,  -2860, // 0xC0-0xC7
+     17466,   4750,   7150,   -960,   9525,    940,   2860,  -3183, // 0xC8-0xCF
+     20666,   7150,   9550,    960,  11925,   2860,   4780,  -1583, // 0xD0-0xD7
+     14300,   4760,   6680,      0,   8580,   1583,   3183,  -2042, // 0xD8-0xDF
+     23833,   9525,  11925,   2860,  14300,   4760,   6680,      0, // 0xE0-0xE7
+     16675,   6660,   8580,   1583,  10480,   3166,   4766,   -685, // 0xE8-0xEF
+     19075,   8580,  10500,   3183,  12400,   4766,   6366,    685, // 0xF0-0xF7
+     14300,   6350,   7950,   2042,   9533,   3400,   4771,      0  // 0xF8-0xFF
+};
+
+// Perform sensor integration
+// Input: data is 8-bit result from line sensor
+// Output: position relative to center of line,
+//         REFLECTANCE_LOST if data is zero
+int32_t Reflectance_Position(uint8_t data){
+    return PositionTable[data];
+}
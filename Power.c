@@ -0,0 +1,118 @@
+// Power.c
+// Runs on MSP432
+// LPM0 idle between scheduler ticks and LPM3 while parked.
+// Both sleeps are entered with interrupts masked after checking
+// for due work, so a tick that arrives between Scheduler_Run()
+// and WFI wakes the core at once instead of a tick late.
+// Team Donkey Kong
+
+#include <stdint.h>
+#include "msp.h"
+#include "Priority.h"
+#include "CortexM.h"
+#include "Scheduler.h"
+#include "Power.h"
+
+static Power_Stats_t Stats;
+static volatile uint32_t Woken;         // CYCCNT at RTC ISR entry, 0 until then
+
+// ------------Power_Init------------
+// Source BCLK from REFO and start the RTC prescaler
+// interrupt every POWER_WAKE_PERIOD seconds.
+// Input: none
+// Output: none
+void Power_Init(void){
+  Stats.idle = Stats.deep = Stats.failed = 0;
+  Stats.wakeMin = Stats.resumeMin = 0xFFFFFFFF;
+  Stats.wakeMax = Stats.resumeMax = 0;
+  CS->KEY = 0x695A;                     // unlock CS module for register access
+  CS->CTL1 |= 0x00001000;               // BCLK sourced from REFOCLK (no LFXT fitted)
+  CS->KEY = 0;                          // lock CS module from unintended access
+  RTC_C->CTL0 = 0xA500;                 // unlock RTC, no RTC interrupts
+  RTC_C->CTL13 = 0x0000;                // calendar mode running, binary
+  RTC_C->PS0CTL = 0x0000;               // RT0PS = BCLK/256 = 128 Hz
+  RTC_C->PS1CTL = (POWER_WAKE_PERIOD == 2)?
+                  0x001E :              // RT1PS = RT0PS/256 = 0.5 Hz, interrupt
+                  0x001A;               // RT1PS = RT0PS/128 = 1 Hz, interrupt
+  RTC_C->CTL0 = 0x0000;                 // lock RTC
+  NVIC_SetPriority(RTC_C_IRQn, PRIORITY_WAKE);
+  NVIC_EnableIRQ(RTC_C_IRQn);
+}
+
+// RTC prescaler interrupt, nothing to do but wake the core
+void RTC_C_IRQHandler(void){
+  Woken = DWT->CYCCNT;
+  (void)RTC_C->IV;                      // reading IV clears RT1PSIFG
+}
+
+// ------------Power_Idle------------
+// LPM0 until the next interrupt. WFI wakes on a pending
+// interrupt even with I=1, and the ISR runs when I is
+// cleared, so nothing can slip in between the check and
+// the sleep.
+// Input: none
+// Output: none
+void Power_Idle(void){
+  uint32_t ticks, latency;
+  DisableInterrupts();
+  if(Scheduler_Pending()){
+    EnableInterrupts();                 // released while we were deciding
+    return;
+  }
+  ticks = Scheduler_Ticks();
+  SCB->SCR &= ~SCB_SCR_SLEEPDEEP_Msk;   // WFI enters LPM0
+  WaitForInterrupt();
+  EnableInterrupts();                   // the wake-up ISR runs here
+  Stats.idle++;
+  if(Scheduler_Ticks() != ticks){
+    latency = Scheduler_Latency();
+    if(latency < Stats.wakeMin) Stats.wakeMin = latency;
+    if(latency > Stats.wakeMax) Stats.wakeMax = latency;
+  }
+}
+
+// ------------Power_Deep------------
+// LPM3 until the RTC or a port interrupt. FORCE_LPM_ENTRY
+// makes the PCM ignore clock requests from the timers and
+// UART that would otherwise turn the sleep into LPM0.
+// The DCO restarts by itself on the wake, so nothing is
+// waited for here.
+// Input: none
+// Output: none
+// Assumes: MCLK on the DCO (CLOCK_12MHZ or CLOCK_24MHZ)
+void Power_Deep(void){
+  uint32_t start, cycles;
+  DisableInterrupts();
+  if(Scheduler_Pending()){
+    EnableInterrupts();
+    return;
+  }
+  PCM->CTL1 = 0x695A0000 | 0x00000004;  // PCM key, force LPM entry
+  PCM->CTL0 = (PCM->CTL0&~0xFFFF00F0) | // clear PCMKEY and LPMR bit fields
+              0x695A0000;               // LPMR = LPM3
+  Woken = 0;
+  SCB->SCR |= SCB_SCR_SLEEPDEEP_Msk;    // WFI enters LPM3
+  WaitForInterrupt();
+  SCB->SCR &= ~SCB_SCR_SLEEPDEEP_Msk;
+  start = DWT->CYCCNT;
+  if(PCM->IFG&0x00000003){
+    PCM->CLRIFG = 0x00000003;           // LPM entry refused, slept in LPM0 at most
+    Stats.failed++;
+  }else{
+    Stats.deep++;
+  }
+  EnableInterrupts();                   // the wake-up ISR runs here
+  if(Woken){                            // the RTC woke us, not a port
+    cycles = Woken - start;
+    if(cycles < Stats.resumeMin) Stats.resumeMin = cycles;
+    if(cycles > Stats.resumeMax) Stats.resumeMax = cycles;
+  }
+}
+
+// ------------Power_GetStats------------
+// Return the sleep statistics.
+// Input: none
+// Output: pointer to the statistics
+const Power_Stats_t *Power_GetStats(void){
+  return &Stats;
+}
@@ -0,0 +1,87 @@
+/**
+ * @file      Power.h
+ * @brief     Low-power idle between scheduler ticks
+ * @details   The main loop calls Power_Idle() whenever Scheduler_Run()
+ * had nothing to do. The core then sleeps in LPM0 (WFI with the clocks
+ * still running) until the next interrupt, normally the next SysTick.
+ * When the robot is parked in the Stop state, Power_Deep() enters
+ * LPM3 instead: MCLK, SMCLK and every timer on them freeze, and only
+ * the RTC (on BCLK = REFO, 32768 Hz) and the port interrupts can wake
+ * the part. The RTC wakes it once every POWER_WAKE_PERIOD seconds.
+ * SysTick is frozen in LPM3, so no task is released by the wake itself:
+ * main idles in LPM0 after Power_Deep() until SysTick, running again,
+ * releases a tick, lets the scheduler run it and log, then goes back
+ * to sleep.<br>
+ * Wake latency is measured on the target and kept in Power_Stats:<br>
+ * LPM0: SysTick cycles from the tick to the SysTick ISR entry,
+ * from Scheduler_Latency(), for ticks that woke the core.<br>
+ * LPM3: CPU cycles from the wake to the RTC ISR entry, for RTC wakes.
+ * This is only the software part: the DCO restart before the first
+ * instruction is not counted by CYCCNT.
+ * @author    Team Donkey Kong
+ * @note      Stop the motors before Power_Deep(); the PWM timer freezes
+ * in whatever state it was in
+ ******************************************************************************/
+
+/*!
+ * @defgroup MSP432
+ * @brief
+ * @{*/
+#ifndef POWER_H_
+#define POWER_H_
+#include <stdint.h>
+
+#define POWER_WAKE_PERIOD 1   // seconds between RTC wakes in LPM3, 1 or 2
+
+/**
+ * \brief Sleep counters and wake latencies, all in CPU cycles
+ */
+struct Power_Stats {
+  uint32_t idle;        // Power_Idle() calls that slept (LPM0)
+  uint32_t deep;        // Power_Deep() calls that slept (LPM3)
+  uint32_t wakeMin;     // fastest LPM0 tick to ISR entry
+  uint32_t wakeMax;     // slowest LPM0 tick to ISR entry
+  uint32_t resumeMin;   // fastest LPM3 wake to RTC ISR entry
+  uint32_t resumeMax;   // slowest LPM3 wake to RTC ISR entry
+  uint32_t failed;      // Power_Deep() calls the PCM refused
+};
+typedef struct Power_Stats Power_Stats_t;
+
+/**
+ * Start the RTC wake-up timer and clear the statistics.
+ * @param  none
+ * @return none
+ * @note   Call after Clock_Init48MHz()
+ * @brief  Initialize low-power idle
+ */
+void Power_Init(void);
+
+/**
+ * Sleep in LPM0 until the next interrupt, unless a task is already due.
+ * @param  none
+ * @return none
+ * @brief  Idle until the next tick
+ */
+void Power_Idle(void);
+
+/**
+ * Sleep in LPM3 until the RTC or a bump switch wakes the part.
+ * @param  none
+ * @return none
+ * @note   Everything clocked from MCLK or SMCLK stops while asleep,
+ * including SysTick, the PWM, the sensor timer and the UART
+ * @note   Switch to a DCO profile with Clock_SetProfile() first; LPM3
+ * stops the HFXT, and only Clock_SetProfile(CLOCK_48MHZ) restarts it
+ * @brief  Deep sleep
+ */
+void Power_Deep(void);
+
+/**
+ * Return the sleep statistics.
+ * @param  none
+ * @return pointer to the statistics, updated by every sleep
+ * @brief  Read the sleep statistics
+ */
+const Power_Stats_t *Power_GetStats(void);
+
+#endif /* POWER_H_ */
@@ -0,0 +1,52 @@
+/**
+ * @file      Priority.h
+ * @brief     Interrupt priorities of every ISR in the project
+ * @details   The MSP432 implements 3 priority bits, so levels are 0
+ * (highest) to 7. All NVIC_SetPriority() calls use the names below, so
+ * the whole preemption order can be read and changed in one place.<br>
+<table>
+<caption id="priorities">Interrupt priorities</caption>
+<tr><th>Level <th>Interrupt       <th>Why
+<tr><td>0     <td>none            <td>kept free for a future fault-level ISR; PendSV in the Benchmark build only
+<tr><td>1     <td>TA0_0, TA1_0/N, PORT4 <td>PWM latch, sensor timing and bumps, a few us each
+<tr><td>2     <td>SysTick, TA3_0/N <td>scheduler tick and tachometer capture
+<tr><td>2     <td>EUSCIA0         <td>parameter command bytes, one every 22 us at 460800 baud
+<tr><td>3     <td>DMA_INT1        <td>telemetry end of transfer
+<tr><td>3     <td>ADC14           <td>battery conversion, once per 20 ms PWM period
+<tr><td>6     <td>RTC_C           <td>LPM3 wake-up, nothing else is running
+<tr><td>7     <td>T32_INT1        <td>time base wrap, once every 89 s
+</table>
+ * StartMasked() raises BASEPRI to PRIORITY_MASK, so code that only
+ * races SysTick, the tachometer or the DMA never delays a level 0 or
+ * 1 ISR. The worst-case latency of those is then set by the other
+ * level 0-1 ISRs and the few PRIMASK sections, not by task code.
+ * @author    Team Donkey Kong
+ * @note      An ISR that shares data with a level 0 or 1 ISR must use
+ * StartCritical(), not StartMasked()
+ ******************************************************************************/
+
+/*!
+ * @defgroup MSP432
+ * @brief
+ * @{*/
+#ifndef PRIORITY_H_
+#define PRIORITY_H_
+
+#define PRIORITY_BENCH      0   // PendSV, entry latency test of Benchmark.c, never in the race build
+#define PRIORITY_PWM        1   // TA0_0, ramp and latch the motor duty
+#define PRIORITY_SENSOR     1   // TA1_0 and TA1_N, reflectance charge and capture
+#define PRIORITY_BUMP       1   // PORT4, bump switch edges
+#define PRIORITY_TICK       2   // SysTick, scheduler releases
+#define PRIORITY_TACH       2   // TA3_0 and TA3_N, wheel encoder capture
+#define PRIORITY_COMMAND    2   // EUSCIA0, parameter command receive
+#define PRIORITY_TELEMETRY  3   // DMA_INT1, UART transfer complete
+#define PRIORITY_BATTERY    3   // ADC14, battery voltage converted
+#define PRIORITY_WAKE       6   // RTC_C, wake-up from LPM3
+#define PRIORITY_TIMEBASE   7   // T32_INT1, time base wrap
+
+/**
+ * \brief StartMasked() blocks this level and below (numerically greater or equal)
+ */
+#define PRIORITY_MASK       2
+
+#endif /* PRIORITY_H_ */
@@ -0,0 +1,109 @@
+// Profile.c
+// Runs on MSP432
+// Hot-path profiler built on the DWT cycle counter.
+// Compiled only when PROFILE is defined, see Profile.h.
+// Team Donkey Kong
+
+#include <stdint.h>
+#include "Profile.h"
+
+#ifdef PROFILE
+#include "msp.h"
+
+struct Profile_Stat ProfileStats[PROFILE_NUM_ZONES];
+
+#define PROFILE_NAME(name) #name,
+static const char * const ZoneNames[PROFILE_NUM_ZONES] = { PROFILE_ZONES(PROFILE_NAME) };
+
+// ------------Profile_Init------------
+// Enable the DWT cycle counter and clear the statistics.
+// The count is left running: the zones only take differences,
+// and the boot trace reads it from reset.
+// Input: none
+// Output: none
+void Profile_Init(void){
+  uint32_t i, j;
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;  // enable trace/DWT
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;             // start the cycle counter, if not yet
+  for(i = 0; i < PROFILE_NUM_ZONES; i++){
+    ProfileStats[i].count = 0;
+    ProfileStats[i].min = 0xFFFFFFFF;
+    ProfileStats[i].max = 0;
+    ProfileStats[i].total = 0;
+    for(j = 0; j < PROFILE_BINS; j++){
+      ProfileStats[i].hist[j] = 0;
+    }
+  }
+}
+
+// ------------Profile_Record------------
+// Add one sample to a zone. Safe to call from ISRs as
+// long as one zone is only measured in one context.
+// Input: zone    zone index
+//        cycles  length in core clock cycles
+// Output: none
+void Profile_Record(uint32_t zone, uint32_t cycles){
+  struct Profile_Stat *s = &ProfileStats[zone];
+  uint32_t bin;
+  s->count = s->count + 1;
+  s->total = s->total + cycles;
+  if(cycles < s->min) s->min = cycles;
+  if(cycles > s->max) s->max = cycles;
+  bin = (cycles == 0)? 0 : 31 - __CLZ(cycles);   // floor(log2(cycles))
+  if(bin >= PROFILE_BINS){
+    bin = PROFILE_BINS - 1;
+  }
+  s->hist[bin] = s->hist[bin] + 1;
+}
+
+// Send a string
+static void OutString(void (*out)(char), const char *s){
+  while(*s){
+    out(*s);
+    s++;
+  }
+}
+
+// Send an unsigned decimal number
+static void OutUDec(void (*out)(char), uint32_t n){
+  char buf[10];
+  int i = 0;
+  do{
+    buf[i] = '0' + n%10;
+    n = n/10;
+    i++;
+  }while(n);
+  while(i){
+    i--;
+    out(buf[i]);
+  }
+}
+
+// ------------Profile_Report------------
+// Print one comma separated line per zone:
+// name,count,min,max,avg,hist0,...,hist15
+// Input: out  function that sends one character
+// Output: none
+void Profile_Report(void (*out)(char)){
+  uint32_t i, j;
+  struct Profile_Stat *s;
+  for(i = 0; i < PROFILE_NUM_ZONES; i++){
+    s = &ProfileStats[i];
+    OutString(out, ZoneNames[i]);
+    out(',');
+    OutUDec(out, s->count);
+    out(',');
+    OutUDec(out, s->count? s->min : 0);
+    out(',');
+    OutUDec(out, s->max);
+    out(',');
+    OutUDec(out, s->count? (uint32_t)(s->total/s->count) : 0);
+    for(j = 0; j < PROFILE_BINS; j++){
+      out(',');
+      OutUDec(out, s->hist[j]);
+    }
+    out('\r');
+    out('\n');
+  }
+}
+#endif
@@ -0,0 +1,103 @@
+/**
+ * @file      Profile.h
+ * @brief     Cycle-accurate hot-path profiler using the DWT cycle counter
+ * @details   Wrap a piece of code in PROFILE_BEGIN(zone)/PROFILE_END(zone)
+ * to measure it in core clock cycles. Every zone keeps count, min, max,
+ * total and a log2 histogram in the RAM table ProfileStats[], which can be
+ * read with the debugger or printed with Profile_Report().<br>
+ * Profiling is compiled in only when PROFILE is defined (add it to the
+ * build's predefined symbols). Without it the probe macros expand to
+ * nothing and Profile.c contributes no code or data.<br>
+ * For repeatable numbers from fixed inputs rather than a run on the
+ * track, build the Benchmark configuration instead (Benchmark.c).
+ * @author    Team Donkey Kong
+ * @note      Times include any interrupts taken inside the zone
+ ******************************************************************************/
+
+/*!
+ * @defgroup MSP432
+ * @brief
+ * @{*/
+#ifndef PROFILE_H_
+#define PROFILE_H_
+#include <stdint.h>
+
+/**
+ * \brief List of profiled zones, X(name) for each
+ */
+#define PROFILE_ZONES(X) \
+  X(PROFILE_TICK)       /* one pass of Scheduler_Run that ran a task */ \
+  X(PROFILE_READ)       /* blocking Reflectance_Read */ \
+  X(PROFILE_SAMPLE)     /* acquisition engine sample ISR */ \
+  X(PROFILE_POSITION)   /* Reflectance_Position and Estimator_Update */ \
+  X(PROFILE_NEXTSTATE)  /* nextStateIDX */ \
+  X(PROFILE_FSM)        /* one FSM_Task */ \
+  X(PROFILE_MOTOR)      /* one Motor_Task */
+
+#define PROFILE_ENUM(name) name,
+enum Profile_Zone { PROFILE_ZONES(PROFILE_ENUM) PROFILE_NUM_ZONES };
+
+#define PROFILE_BINS 16  // histogram bin n counts times of 2^n to 2^(n+1)-1 cycles
+
+/**
+ * \brief Statistics of one zone
+ */
+struct Profile_Stat {
+  uint32_t count;                // number of samples
+  uint32_t min;                  // fewest cycles
+  uint32_t max;                  // most cycles
+  uint64_t total;                // sum of cycles, avg = total/count
+  uint32_t hist[PROFILE_BINS];   // log2 histogram, last bin also holds larger times
+};
+
+#ifdef PROFILE
+#include "msp.h"
+
+extern struct Profile_Stat ProfileStats[PROFILE_NUM_ZONES];
+
+/**
+ * \brief Mark the start of a zone; declares a local, so use once per zone per block
+ */
+#define PROFILE_BEGIN(zone) uint32_t zone##_start = DWT->CYCCNT
+
+/**
+ * \brief Mark the end of a zone started in the same block
+ */
+#define PROFILE_END(zone) Profile_Record(zone, DWT->CYCCNT - zone##_start)
+
+/**
+ * Enable the DWT cycle counter and clear all statistics.
+ * @param  none
+ * @return none
+ * @note   Never resets CYCCNT, so Boot_Micros() stays valid
+ * @brief  Initialize the profiler
+ */
+void Profile_Init(void);
+
+/**
+ * Add one sample to a zone.
+ * @param  zone zone index
+ * @param  cycles measured length in core clock cycles
+ * @return none
+ * @note   Called by PROFILE_END
+ * @brief  Record a sample
+ */
+void Profile_Record(uint32_t zone, uint32_t cycles);
+
+/**
+ * Print one line per zone: name,count,min,max,avg followed by the
+ * histogram bins, comma separated.
+ * @param  out function that sends one character
+ * @return none
+ * @brief  Print the statistics
+ */
+void Profile_Report(void (*out)(char));
+
+#else
+#define PROFILE_BEGIN(zone)
+#define PROFILE_END(zone)
+#define Profile_Init()
+#define Profile_Report(out)
+#endif
+
+#endif /* PROFILE_H_ */
@@ -0,0 +1,34 @@
+// Ram.c
+// Runs on MSP432
+// Relocate the vector table to SRAM. The table sits at the
+// code-bus alias, so the vector fetch on interrupt entry still
+// runs in parallel with stacking on the system bus, but without
+// the flash wait states.
+// Team Donkey Kong
+
+#include <stdint.h>
+#include "msp.h"
+#include "Ram.h"
+
+// VTOR needs the table aligned to its size rounded up to a power of 2
+#pragma DATA_SECTION(RamVectors, ".vtable")
+#pragma DATA_ALIGN(RamVectors, 512)
+static uint32_t RamVectors[RAM_VECTORS];
+
+// ------------Ram_Init------------
+// Copy the vector table to SRAM and point VTOR at it.
+// Input: none
+// Output: none
+void Ram_Init(void){
+#ifndef NO_RAMFUNC
+  const uint32_t *flash = (const uint32_t *)SCB->VTOR;
+  uint32_t i;
+  for(i = 0; i < RAM_VECTORS; i++){
+    RamVectors[i] = flash[i];
+  }
+  __DSB();                              // table written before it is used
+  SCB->VTOR = (uint32_t)RamVectors;
+  __DSB();
+  __ISB();
+#endif
+}
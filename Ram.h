@@ -0,0 +1,45 @@
+/**
+ * @file      Ram.h
+ * @brief     Run hot code and the vector table from SRAM
+ * @details   At 48 MHz the flash needs 2 wait states, so every fetch
+ * miss in a tight loop or an ISR stalls the core. Functions marked
+ * RAMFUNC are placed in .TI.ramfunc, which msp432p401r.cmd loads in
+ * flash and copies to SRAM_CODE (0x01000000 alias, code bus, no wait
+ * states) before main(). Ram_Init() copies the vector table there too
+ * and points VTOR at it.<br>
+ * To measure the saving, build with PROFILE defined, read
+ * Profile_Report() (PROFILE_TICK is the whole control tick), then
+ * rebuild with NO_RAMFUNC defined and compare.
+ * @author    Team Donkey Kong
+ * @note      Keep RAMFUNC for short hot code; SRAM_CODE is 8 KB
+ ******************************************************************************/
+
+/*!
+ * @defgroup MSP432
+ * @brief
+ * @{*/
+#ifndef RAM_H_
+#define RAM_H_
+#include <stdint.h>
+
+/**
+ * \brief Place a function in SRAM, e.g. RAMFUNC void TA0_0_IRQHandler(void)
+ */
+#if defined(__TI_COMPILER_VERSION__) && !defined(NO_RAMFUNC)
+#define RAMFUNC __attribute__((ramfunc))
+#else
+#define RAMFUNC
+#endif
+
+#define RAM_VECTORS 80      // 16 core exceptions + 64 MSP432 interrupts
+
+/**
+ * Copy the flash vector table to SRAM_CODE and switch VTOR to it.
+ * @param  none
+ * @return none
+ * @note   Call once, early in main(), before any interrupt is enabled
+ * @brief  Relocate the vector table
+ */
+void Ram_Init(void);
+
+#endif /* RAM_H_ */
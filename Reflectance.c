@@ -54,7 +54,12 @@ policies, either expressed or implied, of the FreeBSD Project.
 
 #include <stdint.h>
 #include "msp432.h"
+#include "Priority.h"
 #include "..\inc\Clock.h"
+#include "Reflectance.h"
+#include "Profile.h"
+#include "Motor.h"
+#include "Ram.h"
 
 // ------------Reflectance_Init------------
 // Initialize the GPIO pins associated with the QTR-8RC
@@ -81,6 +86,10 @@ void Reflectance_Init(void){
     P7->SEL1 &= ~0xFF;
     P7->DIR &= ~0xFF;
     P7->REN &= ~0xFF;
+
+    // DWT cycle counter used to timestamp discharge in Reflectance_Capture
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
 }
 
 // ------------Reflectance_Read------------
@@ -96,6 +105,7 @@ void Reflectance_Init(void){
 // Assumes: Reflectance_Init() has been called
 uint8_t Reflectance_Read(uint32_t time){
     uint8_t result;
+    PROFILE_BEGIN(PROFILE_READ);
 
     P5->OUT |= 0x08;        // Turn on IR LEDs
     P9->OUT |= 0x04;
@@ -108,6 +118,7 @@ uint8_t Reflectance_Read(uint32_t time){
     P5->OUT &= ~0x08;       // Turn off IR LEDs
     P9->OUT &= ~0x04;
 
+    PROFILE_END(PROFILE_READ);
     return result;
 }
 
@@ -145,26 +156,62 @@ uint8_t Reflectance_Center(uint32_t time){
 }
 
 
-// Perform sensor integration
-// Input: data is 8-bit result from line sensor
-// Output: position in 0.1mm relative to center of line
-int32_t Reflectance_Position(uint8_t data){
-    int32_t position, weightsum=0, bitsum=0;
-    uint8_t b, i;
+// ------------Reflectance_Capture------------
+// Measure the discharge time of each of the eight sensors
+// in a single charge cycle.
+// Turn on the 8 IR LEDs
+// Pulse the 8 sensors high for 10 us
+// Make the sensor pins input
+// Poll P7 and timestamp each falling bit with the DWT cycle counter
+// Turn off the 8 IR LEDs
+// Input: decay   array of 8, receives the discharge time of P7.0-P7.7 in us
+//        timeout us to wait for the slowest sensor (at most 8000)
+// Output: bits still high at timeout (same meaning as Reflectance_Read(timeout))
+// Assumes: Reflectance_Init() has been called
+// Sensors that have not fallen by the timeout read as timeout.
+RAMFUNC uint8_t Reflectance_Capture(uint16_t decay[8], uint32_t timeout){
+    uint32_t start, now, limit, cyclesPerUs;
+    uint8_t remaining, fell, i;
 
-    int32_t w[] = {-33400,-23800,-14300,-4800,4800,14300,23800,33400};
+    if(timeout > REFLECTANCE_MAX_TIMEOUT){
+        timeout = REFLECTANCE_MAX_TIMEOUT;
+    }
+    cyclesPerUs = Clock_GetFreq()/1000000;
+    limit = timeout*cyclesPerUs;
+    remaining = 0xFF;
 
-    for (i = 0; i<8; i++)
-    {
-        b = (data>>i)&1;
-        weightsum += b*w[i];
-        bitsum += b;
+    P5->OUT |= 0x08;        // Turn on IR LEDs
+    P9->OUT |= 0x04;
+    P7->DIR = 0xFF;         // make P7.7-P7.0 out
+    P7->OUT = 0xFF;         // charge the capacitors
+    Clock_Delay1us(10);     // wait 10 us
+    P7->DIR = 0x00;         // make P7.7-P7.0 in
+    start = DWT->CYCCNT;
+    while(remaining){
+        fell = remaining&~P7->IN;       // bits that went low since last poll
+        now = DWT->CYCCNT - start;
+        if(fell){
+            for(i = 0; i < 8; i++){
+                if(fell&(1<<i)){
+                    decay[i] = now/cyclesPerUs;
+                }
+            }
+            remaining &= ~fell;
+        }
+        if(now >= limit){
+            break;
+        }
+    }
+    P5->OUT &= ~0x08;       // Turn off IR LEDs
+    P9->OUT &= ~0x04;
+    for(i = 0; i < 8; i++){
+        if(remaining&(1<<i)){
+            decay[i] = timeout;
+        }
     }
-    position = weightsum/bitsum;
-    return position;
+    return remaining;
 }
 
-
 // ------------Reflectance_Start------------
 // Begin the process of reading the eight sensors
 // Turn on the 8 IR LEDs
@@ -201,3 +248,241 @@ uint8_t Reflectance_End(void){
     return result;
 }
 
+
+// ------------Asynchronous acquisition engine------------
+// TIMER_A1 runs in up mode at 1 MHz (SMCLK=12MHz/4/3), so
+// CCR values are in us. Each period is one acquisition:
+//   CCR0 (TAR=0)     turn on LEDs, start charging P7
+//   CCR1 (10 us)     make P7 input, start discharge
+//   CCR3 (10+time*3/4) read P7 early, as a contrast probe
+//   CCR2 (10+time)   read P7 REFLECTANCE_VOTES times, turn off
+//                    LEDs, publish the majority
+// Results go into a two slot buffer. The ISR always writes the
+// slot that is not being published, then flips Newest, so a
+// reader never sees a half-written sample.
+// A frame whose probe differs from its result had a sensor
+// fall in the last quarter of the sample time, i.e. close to
+// the threshold. Reflectance_Adapt() shortens the sample time
+// while no frame is marginal and lengthens it when many are.
+#define CHARGE_TIME 10               // us to charge the capacitors
+#define FIRST_READ(time) (CHARGE_TIME + (time) - (REFLECTANCE_VOTES/2)*REFLECTANCE_VOTE_SPACING)
+#if REFLECTANCE_MIN_TIME != CHARGE_TIME + (REFLECTANCE_VOTES/2+1)*REFLECTANCE_VOTE_SPACING
+#error "REFLECTANCE_MIN_TIME must keep FIRST_READ() a spacing after CHARGE_TIME"
+#endif
+#define MAX_DEFERS 2                 // reads moved off PWM edges per frame
+static volatile uint8_t Sample[2];   // double buffer of readings
+static volatile uint8_t Newest = 0;  // index of the last complete reading
+static volatile uint32_t Frames = 0; // number of completed readings
+static volatile uint32_t Marginal = 0; // readings that changed after the probe
+static volatile uint16_t Time;       // sample time in use, us
+static volatile uint16_t NextTime;   // sample time to latch at the next CCR0
+static uint8_t Probe;                // early reading of this frame
+static uint8_t Reads[REFLECTANCE_VOTES]; // reads of this frame so far
+static uint8_t NumReads = 0;
+static uint8_t Defers = 0;           // reads of this frame moved off a PWM edge
+static uint32_t Deferred = 0;        // total reads moved off a PWM edge (debugger)
+static uint16_t Slack;               // us from the sample point to the end of the period
+static uint16_t MinTime, MaxTime;    // adaptation limits
+static uint32_t AdaptFrames, AdaptMarginal; // counts at the last adaptation
+
+// ------------Reflectance_Async_Init------------
+// Start the timer-driven acquisition engine on TIMER_A1.
+// Input: period  us between acquisitions (must be > time+10)
+//        time    us to wait after charging before reading
+// Output: none
+// Assumes: Reflectance_Init() and Clock_Init48MHz() have been called
+void Reflectance_Async_Init(uint32_t period, uint32_t time){
+    TIMER_A1->CTL &= ~0x0030;         // halt Timer A1
+    Sample[0] = Sample[1] = 0;
+    Newest = 0;
+    Frames = 0;
+    Marginal = 0;
+    NumReads = Defers = 0;
+    AdaptFrames = AdaptMarginal = 0;
+    Time = NextTime = time;
+    MinTime = MaxTime = time;         // fixed until Reflectance_SetLimits()
+    Slack = period - CHARGE_TIME - time;
+    TIMER_A1->CTL = 0x0280;           // SMCLK, divide by 4
+    TIMER_A1->EX0 = 0x0002;           // divide by 3, 1 MHz
+    TIMER_A1->CCR[0] = period - 1;    // acquisition period
+    TIMER_A1->CCR[1] = CHARGE_TIME;   // end of charge
+    TIMER_A1->CCR[2] = FIRST_READ(time); // first read of the vote
+    TIMER_A1->CCR[3] = CHARGE_TIME + time*3/4; // contrast probe
+    TIMER_A1->CCTL[0] = 0x0010;       // compare mode, interrupt enabled
+    TIMER_A1->CCTL[1] = 0x0010;
+    TIMER_A1->CCTL[2] = 0x0010;
+    TIMER_A1->CCTL[3] = 0x0010;
+    NVIC_SetPriority(TA1_0_IRQn, PRIORITY_SENSOR);  // above SysTick so samples never slip
+    NVIC_SetPriority(TA1_N_IRQn, PRIORITY_SENSOR);
+    NVIC_EnableIRQ(TA1_0_IRQn);
+    NVIC_EnableIRQ(TA1_N_IRQn);
+    TIMER_A1->CTL |= 0x0014;          // reset and start Timer A1 in up mode
+}
+
+// CCR0: start of a new acquisition, begin charging.
+// A new sample time is latched here, so no frame mixes two.
+RAMFUNC void TA1_0_IRQHandler(void){
+    uint32_t time;
+    TIMER_A1->CCTL[0] &= ~0x0001;     // acknowledge CCR0
+    time = NextTime;
+    if(time != Time){
+        Time = time;
+        TIMER_A1->CCR[0] = CHARGE_TIME + time + Slack - 1;
+        TIMER_A1->CCR[3] = CHARGE_TIME + time*3/4;
+        TIMER_A1->CCR[2] = FIRST_READ(time);
+    }
+    P5->OUT |= 0x08;                  // Turn on IR LEDs
+    P9->OUT |= 0x04;
+    P7->DIR = 0xFF;                   // make P7.7-P7.0 out
+    P7->OUT = 0xFF;                   // charge the capacitors
+}
+
+// Bitwise majority of the reads of one frame
+RAMFUNC static uint8_t Vote(void){
+#if REFLECTANCE_VOTES == 1
+    return Reads[0];
+#elif REFLECTANCE_VOTES == 3
+    return (Reads[0]&Reads[1])|(Reads[0]&Reads[2])|(Reads[1]&Reads[2]);
+#else
+    uint32_t i, bit, count;
+    uint8_t result = 0;
+    for(bit = 0x01; bit <= 0x80; bit = bit<<1){
+        count = 0;
+        for(i = 0; i < REFLECTANCE_VOTES; i++){
+            count += (Reads[i]&bit)? 1 : 0;
+        }
+        if(count > REFLECTANCE_VOTES/2){
+            result |= bit;
+        }
+    }
+    return result;
+#endif
+}
+
+// CCR1: charge complete, CCR3: probe, CCR2: each read of the vote.
+// CCR2 is moved forward by one spacing after every read (or
+// instead of a read that would meet a PWM edge), and put back
+// at the first read after the last one.
+RAMFUNC void TA1_N_IRQHandler(void){
+    uint8_t slot;
+    switch(TIMER_A1->IV){             // reading IV clears the highest pending flag
+    case 0x02:                        // CCR1
+        P7->DIR = 0x00;               // make P7.7-P7.0 in
+        break;
+    case 0x06:                        // CCR3
+        Probe = P7->IN;
+        break;
+    case 0x04:{                       // CCR2
+        if((Defers < MAX_DEFERS) && Motor_NearEdge()){
+            Defers++;
+            Deferred = Deferred + 1;
+            TIMER_A1->CCR[2] += REFLECTANCE_VOTE_SPACING;
+            break;
+        }
+        Reads[NumReads] = P7->IN;     // convert P7 input to digital
+        NumReads++;
+        if(NumReads < REFLECTANCE_VOTES){
+            TIMER_A1->CCR[2] += REFLECTANCE_VOTE_SPACING;
+            break;
+        }
+        PROFILE_BEGIN(PROFILE_SAMPLE);
+        P5->OUT &= ~0x08;             // Turn off IR LEDs
+        P9->OUT &= ~0x04;
+        TIMER_A1->CCR[2] = FIRST_READ(Time);
+        NumReads = 0;
+        Defers = 0;
+        slot = Newest^1;
+        Sample[slot] = Vote();
+        if(Sample[slot] != Probe){
+            Marginal = Marginal + 1;
+        }
+        Newest = slot;                // publish
+        Frames = Frames + 1;
+        PROFILE_END(PROFILE_SAMPLE);
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+// ------------Reflectance_Get------------
+// Return the last reading from the acquisition engine
+// without waiting.
+// Input: none
+// Output: sensor readings
+// Assumes: Reflectance_Async_Init() has been called
+uint8_t Reflectance_Get(void){
+    return Sample[Newest];
+}
+
+// ------------Reflectance_Frames------------
+// Return the number of readings completed by the
+// acquisition engine; changes when a new reading is ready.
+// Input: none
+// Output: reading count
+uint32_t Reflectance_Frames(void){
+    return Frames;
+}
+
+// ------------Reflectance_SetTime------------
+// Change the sample time of the acquisition engine. The
+// period changes with it, keeping the dead time from
+// Reflectance_Async_Init(). Takes effect at the next frame.
+// Shorter times are raised to REFLECTANCE_MIN_TIME: below it
+// the first vote would read P7 while it is still driven high.
+// Input: time  us to wait after charging before reading
+// Output: none
+void Reflectance_SetTime(uint32_t time){
+    if(time < REFLECTANCE_MIN_TIME) time = REFLECTANCE_MIN_TIME;
+    NextTime = time;
+}
+
+// ------------Reflectance_GetTime------------
+// Return the sample time in use.
+// Input: none
+// Output: sample time in us
+uint32_t Reflectance_GetTime(void){
+    return Time;
+}
+
+// ------------Reflectance_SetLimits------------
+// Set the range Reflectance_Adapt() may move the sample time
+// in, usually minTime/maxTime of the calibration profile.
+// Both are raised to REFLECTANCE_MIN_TIME if below it.
+// Input: min  shortest sample time in us
+//        max  longest sample time in us
+// Output: none
+void Reflectance_SetLimits(uint32_t min, uint32_t max){
+    if(min < REFLECTANCE_MIN_TIME) min = REFLECTANCE_MIN_TIME;
+    if(max < REFLECTANCE_MIN_TIME) max = REFLECTANCE_MIN_TIME;
+    MinTime = min;
+    MaxTime = max;
+    if(NextTime < min) NextTime = min;
+    if(NextTime > max) NextTime = max;
+}
+
+// ------------Reflectance_Adapt------------
+// Every REFLECTANCE_ADAPT_FRAMES frames, shorten the sample
+// time by 1/16 if no frame was marginal, or lengthen it by
+// 1/8 if more than 1 in 16 were. Run as a periodic task.
+// Input: none
+// Output: none
+void Reflectance_Adapt(void){
+    uint32_t frames = Frames - AdaptFrames;
+    uint32_t marginal = Marginal - AdaptMarginal;
+    uint32_t time = NextTime;
+    if(frames < REFLECTANCE_ADAPT_FRAMES){
+        return;
+    }
+    AdaptFrames += frames;
+    AdaptMarginal += marginal;
+    if(marginal == 0){
+        time = time - time/16;
+    }else if(marginal > frames/16){
+        time = time + time/8;
+    }
+    if(time < MinTime) time = MinTime;
+    if(time > MaxTime) time = MaxTime;
+    NextTime = time;
+}
@@ -73,6 +73,17 @@ policies, either expressed or implied, of the FreeBSD Project.
  * @{*/
 #ifndef REFLECTANCE_H_
 #define REFLECTANCE_H_
+#include <stdint.h>
+
+/**
+ * \brief Longest discharge time Reflectance_Capture() will wait for, in us
+ */
+#define REFLECTANCE_MAX_TIMEOUT 8000
+
+/**
+ * \brief Position returned when no line can be seen
+ */
+#define REFLECTANCE_LOST 0x7FFFFFFF
 
 
 /**
@@ -142,10 +153,30 @@ uint8_t Reflectance_Center(uint32_t time);
  * @param  data is 8-bit result from line sensor
  * @return position in 0.1mm relative to center of line
  * @brief  Perform sensor integration.
- * @note returns 333 if data is zero (off the line)
+ * @note returns REFLECTANCE_LOST if data is zero (off the line)
+ * @note implemented as a single lookup in a 256-entry table in flash
+ * @note hardware independent, in Position.c
  * */
 int32_t Reflectance_Position(uint8_t data);
 
+/**
+ * <b>Measure the discharge time of each sensor</b>:<br>
+  1) Turn on the 8 IR LEDs<br>
+  2) Pulse the 8 sensors high for 10 us<br>
+  3) Make the sensor pins input<br>
+  4) Poll the sensors, timestamping each falling edge with the DWT cycle counter<br>
+  5) Stop when all have fallen or <b>timeout</b> us have passed<br>
+  6) Turn off the 8 IR LEDs<br>
+ * All eight times come from the same charge cycle. Longer times mean darker surface.
+ * @param  decay array of 8 that receives the discharge times of P7.0-P7.7 in us
+ * @param  timeout us to wait for the slowest sensor, at most REFLECTANCE_MAX_TIMEOUT
+ * @return 8-bit result of sensors still high at timeout
+ * @note Assumes Reflectance_Init() has been called
+ * @note Busy-waits up to timeout us; do not call while the acquisition engine is running
+ * @brief  Capture the discharge time of the eight sensors.
+ */
+uint8_t Reflectance_Capture(uint16_t decay[8], uint32_t timeout);
+
 /**
  * <b>Begin the process of reading the eight sensors</b>:<br>
   1) Turn on the 8 IR LEDs<br>
@@ -171,15 +202,114 @@ void Reflectance_Start(void);
  */
 uint8_t Reflectance_End(void);
 
+/**
+ * <b>Start the timer-driven acquisition engine</b>:<br>
+  1) TIMER_A1 CCR0 turns on the IR LEDs and charges the sensors<br>
+  2) CCR1 makes the sensor pins input 10 us later<br>
+  3) CCR2 reads the sensors <b>time</b> us after that<br>
+  4) The reading is published to a double buffer<br>
+ * Step 3 is really REFLECTANCE_VOTES reads, REFLECTANCE_VOTE_SPACING
+ * apart and centered on the sample time; each bit of the result is the
+ * majority of its reads. A read that would land next to a motor PWM
+ * edge (Motor_NearEdge()) waits one spacing, at most twice per frame.
+ * No CPU time is spent waiting; the buffer is read with Reflectance_Get().
+ * @param  period us between acquisitions, must be greater than
+ * time+10+(REFLECTANCE_VOTES/2+2)*REFLECTANCE_VOTE_SPACING
+ * @param  time delay value in us
+ * @return none
+ * @note Assumes Reflectance_Init() and Clock_Init48MHz() have been called
+ * @note Do not call Reflectance_Read(), Reflectance_Center(),
+ * Reflectance_Start() or Reflectance_End() while the engine is running
+ * @brief  Start interrupt driven sampling of the eight sensors.
+ */
+void Reflectance_Async_Init(uint32_t period, uint32_t time);
+
 /**
  * <b>Return last reading</b>
  * @param  none
  * @return 8-bit result
- * @note  Assumes: Reflectance_Init() has been called
- * @note  Assumes: Reflectance_Start() was called
- * @note  Assumes: Reflectance_End() was called 1 ms after Start
+ * @note  Assumes: Reflectance_Async_Init() has been called
+ * @note  Never blocks; returns the most recent complete reading
  * @brief  Get last reading of the eight sensors.
  */
 uint8_t Reflectance_Get(void);
 
+/**
+ * <b>Return the number of completed readings</b>
+ * @param  none
+ * @return reading count, increments once per acquisition period
+ * @note  Assumes: Reflectance_Async_Init() has been called
+ * @brief  Count of readings from the acquisition engine.
+ */
+uint32_t Reflectance_Frames(void);
+
+/**
+ * \brief Reads of P7 per acquisition, combined by a bitwise majority vote (odd, 1 to 7)
+ */
+#ifndef REFLECTANCE_VOTES
+#define REFLECTANCE_VOTES 3
+#endif
+
+/**
+ * \brief us between the reads of one vote, centered on the sample time
+ */
+#define REFLECTANCE_VOTE_SPACING 10
+
+/**
+ * \brief Shortest sample time of the engine: the first read of the vote
+ * comes at least one spacing after the 10 us charge ends
+ */
+#define REFLECTANCE_MIN_TIME (10 + (REFLECTANCE_VOTES/2+1)*REFLECTANCE_VOTE_SPACING)
+
+/**
+ * \brief Frames between sample time adjustments by Reflectance_Adapt()
+ */
+#define REFLECTANCE_ADAPT_FRAMES 64
+
+/**
+ * <b>Change the sample time</b>
+ * @param  time us to wait after charging before reading
+ * @return none
+ * @note  Times below REFLECTANCE_MIN_TIME are raised to it
+ * @note  Latched at the start of the next frame; the period changes by
+ * the same amount, so the dead time set by Reflectance_Async_Init() stays
+ * @brief  Set the acquisition engine sample time.
+ */
+void Reflectance_SetTime(uint32_t time);
+
+/**
+ * <b>Return the sample time in use</b>
+ * @param  none
+ * @return sample time in us
+ * @brief  Get the acquisition engine sample time.
+ */
+uint32_t Reflectance_GetTime(void);
+
+/**
+ * <b>Set the adaptation range</b>
+ * @param  min shortest sample time in us
+ * @param  max longest sample time in us
+ * @return none
+ * @note  Both are raised to REFLECTANCE_MIN_TIME if below it
+ * @note  Reflectance_Async_Init() sets both to its time, so the engine
+ * does not adapt until this is called (usually with the limits of the
+ * calibration profile, see Calibrate.h)
+ * @brief  Limit the adaptive sample time.
+ */
+void Reflectance_SetLimits(uint32_t min, uint32_t max);
+
+/**
+ * <b>Adapt the sample time to the contrast</b>:<br>
+ * Each frame also reads the sensors at 3/4 of the sample time. A frame
+ * is marginal if a sensor fell between the two reads. With no marginal
+ * frames the sample time is shortened by 1/16, with more than 1 in 16
+ * it is lengthened by 1/8, within the limits.
+ * @param  none
+ * @return none
+ * @note  Call periodically; it does nothing until REFLECTANCE_ADAPT_FRAMES
+ * new frames are in
+ * @brief  Adjust the sample time from recent frames.
+ */
+void Reflectance_Adapt(void);
+
 #endif /* REFLECTANCE_H_ */
@@ -0,0 +1,201 @@
+// Scheduler.c
+// Runs on MSP432
+// SysTick-driven fixed-rate task scheduler. The ISR only counts
+// releases; the tasks themselves run in the foreground from
+// Scheduler_Run() so a long task can never block the tick.
+// Team Donkey Kong
+
+#include <stdint.h>
+#include "msp.h"
+#include "Priority.h"
+#include "Clock.h"
+#include "CortexM.h"
+#include "Scheduler.h"
+#include "Ram.h"
+
+struct Task {
+  void (*function)(void);      // task body
+  uint32_t period;             // ticks between releases
+  uint32_t countdown;          // ticks until next release
+  volatile uint32_t released;  // incremented by SysTick ISR
+  uint32_t serviced;           // incremented by Scheduler_Run
+  uint32_t overruns;           // releases that were dropped
+};
+typedef struct Task Task_t;
+
+static Task_t Tasks[SCHEDULER_MAX_TASKS];
+static uint32_t NumTasks = 0;
+static volatile uint32_t Ticks = 0;
+static uint32_t Rate = 1000;           // tick rate in Hz
+static volatile uint32_t Latency = 0;  // cycles from the reload to the last ISR entry
+static uint32_t WorstLoop = 0;         // cycles from a tick to the end of its tasks
+static uint32_t Late = 0;              // runs that were overtaken by the next tick
+
+// ------------Scheduler_Init------------
+// Initialize SysTick for periodic interrupts at the
+// given rate, priority PRIORITY_TICK. SysTick stays off until
+// Scheduler_Start() is called.
+// Input: rate  tick rate in Hz
+// Output: none
+void Scheduler_Init(uint32_t rate){
+  SysTick->CTRL = 0;                           // disable SysTick during setup
+  Rate = rate;
+  SysTick->LOAD = Clock_GetFreq()/rate - 1;    // reload value
+  SysTick->VAL = 0;                            // any write to current clears it
+  NVIC_SetPriority(SysTick_IRQn, PRIORITY_TICK);
+  NumTasks = 0;
+  Ticks = 0;
+  WorstLoop = 0;
+  Late = 0;
+}
+
+// ------------Scheduler_Retime------------
+// Recompute the SysTick reload after a clock change so
+// the tick rate stays the same. The tick in progress
+// restarts, so at most one tick is stretched.
+// Input: none
+// Output: none
+void Scheduler_Retime(void){
+  SysTick->LOAD = Clock_GetFreq()/Rate - 1;
+  SysTick->VAL = 0;
+}
+
+// ------------Scheduler_AddTask------------
+// Register a periodic task. Tasks run in the order
+// they were added.
+// Input: task    function to run
+//        period  ticks between runs (1 = every tick)
+// Output: task index, or -1 if the table is full
+int32_t Scheduler_AddTask(void(*task)(void), uint32_t period){
+  Task_t *t;
+  if((NumTasks >= SCHEDULER_MAX_TASKS) || (period == 0)){
+    return -1;
+  }
+  t = &Tasks[NumTasks];
+  t->function = task;
+  t->period = period;
+  t->countdown = period;
+  t->released = 0;
+  t->serviced = 0;
+  t->overruns = 0;
+  NumTasks = NumTasks + 1;
+  return NumTasks - 1;
+}
+
+// ------------Scheduler_Start------------
+// Start SysTick with core clock source and interrupts.
+// Input: none
+// Output: none
+void Scheduler_Start(void){
+  SysTick->VAL = 0;
+  SysTick->CTRL = 0x00000007;  // enable SysTick with core clock and interrupts
+  EnableInterrupts();
+}
+
+// ------------SysTick_Handler------------
+// Release every task whose period has elapsed.
+// Executes once per tick.
+RAMFUNC void SysTick_Handler(void){
+  uint32_t i;
+  Latency = SysTick->LOAD - SysTick->VAL;     // first, so it sees only the entry time
+  Ticks = Ticks + 1;
+  for(i = 0; i < NumTasks; i++){
+    Tasks[i].countdown = Tasks[i].countdown - 1;
+    if(Tasks[i].countdown == 0){
+      Tasks[i].countdown = Tasks[i].period;
+      Tasks[i].released = Tasks[i].released + 1;
+    }
+  }
+}
+
+// ------------Scheduler_Run------------
+// Run each released task once, in registration order.
+// The ISR only writes released and the foreground only
+// writes serviced, so no critical section is needed.
+// Afterwards the time since the tick is read from SysTick;
+// every tick that came meanwhile adds a full period.
+// Input: none
+// Output: number of tasks run
+RAMFUNC uint32_t Scheduler_Run(void){
+  uint32_t i, released, count = 0, ticks = Ticks, load, elapsed;
+  for(i = 0; i < NumTasks; i++){
+    released = Tasks[i].released;
+    if(released != Tasks[i].serviced){
+      Tasks[i].overruns += (released - Tasks[i].serviced) - 1;
+      Tasks[i].serviced = released;
+      Tasks[i].function();
+      count = count + 1;
+    }
+  }
+  if(count){
+    load = SysTick->LOAD;
+    elapsed = load - SysTick->VAL;
+    if(Ticks != ticks){
+      Late = Late + 1;
+      elapsed += (Ticks - ticks)*(load + 1);
+    }
+    if(elapsed > WorstLoop){
+      WorstLoop = elapsed;
+    }
+  }
+  return count;
+}
+
+// ------------Scheduler_Pending------------
+// Check whether any task has been released but not run.
+// Input: none
+// Output: 1 if Scheduler_Run() has work, 0 if not
+int Scheduler_Pending(void){
+  uint32_t i;
+  for(i = 0; i < NumTasks; i++){
+    if(Tasks[i].released != Tasks[i].serviced){
+      return 1;
+    }
+  }
+  return 0;
+}
+
+// ------------Scheduler_Ticks------------
+// Return the number of ticks since Scheduler_Start().
+// Input: none
+// Output: tick count
+uint32_t Scheduler_Ticks(void){
+  return Ticks;
+}
+
+// ------------Scheduler_Overruns------------
+// Return the overrun count of one task.
+// Input: id  task index from Scheduler_AddTask()
+// Output: overrun count, 0 if id is invalid
+uint32_t Scheduler_Overruns(int32_t id){
+  if((id < 0) || (id >= (int32_t)NumTasks)){
+    return 0;
+  }
+  return Tasks[id].overruns;
+}
+
+// ------------Scheduler_Latency------------
+// Return the interrupt latency of the most recent tick.
+// Input: none
+// Output: core clock cycles from the SysTick reload to
+//         the first instruction of SysTick_Handler
+uint32_t Scheduler_Latency(void){
+  return Latency;
+}
+
+// ------------Scheduler_WorstLoop------------
+// Return the longest loop time seen.
+// Input: none
+// Output: core clock cycles from a tick to the end of the
+//         tasks run after it
+uint32_t Scheduler_WorstLoop(void){
+  return WorstLoop;
+}
+
+// ------------Scheduler_Late------------
+// Return the number of runs overtaken by the next tick.
+// Input: none
+// Output: late run count
+uint32_t Scheduler_Late(void){
+  return Late;
+}
@@ -0,0 +1,131 @@
+/**
+ * @file      Scheduler.h
+ * @brief     SysTick-driven fixed-rate task scheduler
+ * @details   SysTick interrupts at a fixed tick rate. Each registered
+ * task has a period in ticks; the SysTick ISR only releases tasks that
+ * are due, and Scheduler_Run() executes released tasks in the foreground
+ * in the order they were added (first added runs first).<br>
+ 1) Call Scheduler_Init() with the tick rate<br>
+ 2) Register tasks with Scheduler_AddTask()<br>
+ 3) Call Scheduler_Start() then Scheduler_Run() from the main loop<br>
+ * Task bodies must be short and never busy-wait a full tick.
+ * @author    Team Donkey Kong
+ * @note      Tick rate is derived from Clock_GetFreq(), so call
+ * Clock_Init48MHz() before Scheduler_Init()
+ ******************************************************************************/
+
+/*!
+ * @defgroup MSP432
+ * @brief
+ * @{*/
+#ifndef SCHEDULER_H_
+#define SCHEDULER_H_
+#include <stdint.h>
+
+/**
+ * \brief Maximum number of tasks that can be registered
+ */
+#define SCHEDULER_MAX_TASKS 8
+
+/**
+ * Initialize SysTick for periodic interrupts at the given rate.
+ * SysTick is left stopped until Scheduler_Start() is called.
+ * @param  rate is the tick rate in Hz (e.g. 1000 for a 1 ms tick)
+ * @return none
+ * @note   Assumes the bus clock has already been configured
+ * @brief  Initialize the scheduler tick
+ */
+void Scheduler_Init(uint32_t rate);
+
+/**
+ * Keep the tick rate after the core clock changes.
+ * @param  none
+ * @return none
+ * @note   Call right after Clock_SetProfile()
+ * @brief  Retime the scheduler tick
+ */
+void Scheduler_Retime(void);
+
+/**
+ * Register a periodic task.
+ * @param  task is the function to run
+ * @param  period is the number of ticks between runs (1 = every tick)
+ * @return task index 0 to SCHEDULER_MAX_TASKS-1, or -1 if the table is full
+ * @note   Tasks run in the order they are added
+ * @brief  Add a periodic task
+ */
+int32_t Scheduler_AddTask(void(*task)(void), uint32_t period);
+
+/**
+ * Start the SysTick tick and enable interrupts.
+ * @param  none
+ * @return none
+ * @brief  Start the scheduler
+ */
+void Scheduler_Start(void);
+
+/**
+ * Run every task that the SysTick ISR has released since the last call.
+ * A task that was released more than once before it could run is run once
+ * and the extra releases are counted as overruns.
+ * @param  none
+ * @return number of tasks run (0 means nothing was due)
+ * @brief  Foreground task dispatcher
+ */
+uint32_t Scheduler_Run(void);
+
+/**
+ * Check whether any task is waiting to run, without running it.
+ * @param  none
+ * @return 1 if Scheduler_Run() would run a task, 0 if not
+ * @note   Call with interrupts disabled before sleeping
+ * @brief  Check for released tasks
+ */
+int Scheduler_Pending(void);
+
+/**
+ * Return the number of ticks since Scheduler_Start().
+ * @param  none
+ * @return tick count (wraps after 2^32 ticks)
+ * @brief  Read the tick counter
+ */
+uint32_t Scheduler_Ticks(void);
+
+/**
+ * Return the number of times a task was released again before it ran.
+ * @param  id is the index returned by Scheduler_AddTask()
+ * @return overrun count for that task
+ * @brief  Read a task's overrun counter
+ */
+uint32_t Scheduler_Overruns(int32_t id);
+
+/**
+ * Return the latency of the most recent tick interrupt.
+ * @param  none
+ * @return core clock cycles from the SysTick reload to SysTick_Handler entry
+ * @note   Includes the wake-up time when the tick woke the core from sleep
+ * @brief  Read the tick interrupt latency
+ */
+uint32_t Scheduler_Latency(void);
+
+/**
+ * Return the longest time from a tick to the end of the tasks it
+ * released, over every Scheduler_Run() that ran a task.
+ * @param  none
+ * @return core clock cycles; a tick period or more means tasks ran late
+ * @brief  Read the worst loop time
+ */
+uint32_t Scheduler_WorstLoop(void);
+
+/**
+ * Return the number of Scheduler_Run() calls that were still running
+ * tasks when the next tick came.
+ * @param  none
+ * @return late loop count
+ * @note   A late loop is not an overrun yet: the next tick's tasks
+ * still run, only later than they were released
+ * @brief  Read the late loop counter
+ */
+uint32_t Scheduler_Late(void);
+
+#endif /* SCHEDULER_H_ */
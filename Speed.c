@@ -0,0 +1,94 @@
+// Speed.c
+// Runs on MSP432
+// Per-wheel speed loop: feedforward duty plus a PI correction
+// on the tachometer error. A zero setpoint coasts the wheel at
+// duty 0 and clears its integrator.
+// Team Donkey Kong
+
+#include <stdint.h>
+#include "FixedPoint.h"
+#include "PID.h"
+#include "Motor.h"
+#include "Tachometer.h"
+#include "Speed.h"
+
+#define SPEED_KP   FX_Q16(4.0)    // duty per 0.1 rpm of error
+#define SPEED_KI   FX_Q16(0.5)    // per update
+#define SPEED_IMAX 30000          // integrator clamp, Ki*IMAX is full duty
+
+static PID_t Loop[2];             // indexed by TACH_LEFT, TACH_RIGHT
+static int32_t Target[2];         // setpoints in 0.1 rpm
+
+// Duty for one wheel; never drives against the setpoint
+static int32_t Control(uint32_t wheel){
+  int32_t target = Target[wheel];
+  int32_t duty;
+  if(target == 0){
+    PID_Reset(&Loop[wheel]);
+    return 0;
+  }
+  duty = (target*FX_DUTY_MAX)/SPEED_MAX;
+  duty = FX_SatAdd(duty, PID_Update(&Loop[wheel], target - Tachometer_Speed(wheel)));
+  if(target > 0){
+    return FX_Clamp(duty, 0, FX_DUTY_MAX);
+  }
+  return FX_Clamp(duty, -FX_DUTY_MAX, 0);
+}
+
+// ------------Speed_Init------------
+// Initialize the tachometer and both controllers.
+// Input: none
+// Output: none
+void Speed_Init(void){
+  uint32_t i;
+  Tachometer_Init();
+  for(i = 0; i < 2; i++){
+    PID_Init(&Loop[i], SPEED_KP, SPEED_KI, 0, SPEED_IMAX, FX_DUTY_MAX);
+    Target[i] = 0;
+  }
+}
+
+// ------------Speed_Set------------
+// Set the wheel speed setpoints.
+// Input: left, right  speeds in 0.1 rpm, negative is backward
+// Output: none
+void Speed_Set(int32_t left, int32_t right){
+  Target[TACH_LEFT] = FX_Clamp(left, -SPEED_MAX, SPEED_MAX);
+  Target[TACH_RIGHT] = FX_Clamp(right, -SPEED_MAX, SPEED_MAX);
+}
+
+// ------------Speed_Command------------
+// Set the setpoints from a MOTOR_CMD() word, reading
+// each duty as a speed (FX_DUTY_MAX = SPEED_MAX).
+// Input: command  direction and duty-equivalent speeds
+// Output: none
+void Speed_Command(uint32_t command){
+  int32_t left = (MOTOR_CMD_LEFT(command)*SPEED_MAX)/FX_DUTY_MAX;
+  int32_t right = (MOTOR_CMD_RIGHT(command)*SPEED_MAX)/FX_DUTY_MAX;
+  if(MOTOR_CMD_DIR(command)&MOTOR_DIR_LEFT){
+    left = -left;                 // bit 4: left wheel backward
+  }
+  if(MOTOR_CMD_DIR(command)&MOTOR_DIR_RIGHT){
+    right = -right;               // bit 5: right wheel backward
+  }
+  Speed_Set(left, right);
+}
+
+// ------------Speed_Update------------
+// Run both loops once and send the duties to the motors.
+// Input: none
+// Output: none
+void Speed_Update(void){
+  int32_t left = Control(TACH_LEFT);
+  int32_t right = Control(TACH_RIGHT);
+  uint32_t dir = MOTOR_DIR_FORWARD;
+  if(left < 0){
+    dir |= MOTOR_DIR_LEFT;
+    left = -left;
+  }
+  if(right < 0){
+    dir |= MOTOR_DIR_RIGHT;
+    right = -right;
+  }
+  Motor_Command(MOTOR_CMD(dir, left, right));
+}
@@ -0,0 +1,60 @@
+/**
+ * @file      Speed.h
+ * @brief     Per-wheel speed control loop
+ * @details   Inner PI loop that turns a commanded wheel speed into a
+ * motor duty. Each wheel gets a feedforward duty proportional to its
+ * setpoint plus a PI correction from the tachometer error, so the
+ * robot holds its speed as the battery drains or the floor changes.<br>
+ * Speed_Command() accepts the same MOTOR_CMD() words as
+ * Motor_Command(), reading each duty as a speed: duty FX_DUTY_MAX
+ * means SPEED_MAX. The FSM table and the PID steering keep their
+ * units and become velocity commands.
+ * @author    Team Donkey Kong
+ * @note      Call Speed_Update() at a fixed rate; the gains assume 100 Hz
+ ******************************************************************************/
+
+/*!
+ * @defgroup RSLK_Control
+ * @brief
+ * @{*/
+#ifndef SPEED_H_
+#define SPEED_H_
+#include <stdint.h>
+
+#define SPEED_MAX 1500      // wheel speed at full duty, 0.1 rpm (no load)
+
+/**
+ * Initialize the tachometer and both speed controllers.
+ * @param  none
+ * @return none
+ * @note   Call after Motor_Init()
+ * @brief  Initialize the speed loop
+ */
+void Speed_Init(void);
+
+/**
+ * Set the wheel speed setpoints.
+ * @param  left left wheel speed, 0.1 rpm, negative is backward
+ * @param  right right wheel speed, 0.1 rpm, negative is backward
+ * @return none
+ * @brief  Set wheel speeds
+ */
+void Speed_Set(int32_t left, int32_t right);
+
+/**
+ * Set the wheel speed setpoints from a motor command word.
+ * @param  command direction and duty-equivalent speeds packed by MOTOR_CMD()
+ * @return none
+ * @brief  Set wheel speeds from a motor command
+ */
+void Speed_Command(uint32_t command);
+
+/**
+ * Run one update of both speed loops and send the duties to the motors.
+ * @param  none
+ * @return none
+ * @brief  Run the speed loops
+ */
+void Speed_Update(void);
+
+#endif /* SPEED_H_ */
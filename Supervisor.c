@@ -0,0 +1,141 @@
+// Supervisor.c
+// Runs on MSP432
+// Deadline monitor on the scheduler's overrun counters, WDT_A
+// restarted only by the last task of the tick, fault handlers
+// that stop the motors, and a fault record kept across resets.
+// Team Donkey Kong
+
+#include <stdint.h>
+#include "msp.h"
+#include "Clock.h"
+#include "Motor.h"
+#include "Scheduler.h"
+#include "Telemetry.h"
+#include "Supervisor.h"
+
+#define WDT_RUN  0x5A6E     // password, BCLK, watchdog mode, clear count, 2^9 cycles
+#define WDT_HOLD 0x5A80     // password, hold
+
+#pragma NOINIT(Record)
+static Supervisor_Fault_t Record;
+
+static uint32_t Overruns[SCHEDULER_MAX_TASKS];  // counters at the last check
+static uint8_t Tripped;
+static uint32_t Reports;                        // ticks until the next report
+
+// Worst loop time so far in us
+static uint32_t WorstMicros(void){
+  return Scheduler_WorstLoop()/(Clock_GetFreq()/1000000);
+}
+
+// Fill in the record of a fault
+static void Record_Fault(uint8_t reason, uint8_t task, uint32_t detail){
+  Record.reason = reason;
+  Record.task = task;
+  Record.detail = detail;
+  Record.tick = Scheduler_Ticks();
+  Record.worst = WorstMicros();
+}
+
+// ------------Supervisor_Init------------
+// Clear the record after a power-up, add the watchdog as
+// the reason of a reset nothing else recorded, and arm
+// WDT_A with a hard reset on timeout.
+// Input: none
+// Output: none
+void Supervisor_Init(void){
+  uint32_t i;
+  if(Record.magic != SUPERVISOR_MAGIC){
+    Record.magic = SUPERVISOR_MAGIC;   // power-up, RAM is random
+    Record.reason = SUPERVISOR_NONE;
+    Record.task = 0;
+    Record.pending = 0;
+    Record.detail = Record.tick = Record.worst = 0;
+    Record.resets = 0;
+  }
+  if(RSTCTL->HARDRESET_STAT&0x00000002){
+    RSTCTL->HARDRESET_CLR = 0x00000002; // SRC1, WDT_A time-out
+    if(!Record.pending){
+      Record_Fault(SUPERVISOR_WATCHDOG, 0, 0);  // tick and worst of this boot, 0
+    }
+    Record.resets++;
+  }
+  Record.pending = 0;
+  for(i = 0; i < SCHEDULER_MAX_TASKS; i++){
+    Overruns[i] = Scheduler_Overruns(i);
+  }
+  Tripped = 0;
+  Reports = SUPERVISOR_REPORT;
+  SYSCTL->WDTRESET_CTL |= 0x00000001;  // time-out is a hard reset: timers and ports too
+  WDT_A->CTL = WDT_RUN;
+}
+
+// ------------Supervisor_Task------------
+// Stop on the first lost release, restart the watchdog and
+// send a report every SUPERVISOR_REPORT ticks.
+// Input: none
+// Output: none
+void Supervisor_Task(void){
+  uint32_t i, n;
+  Telemetry_Record_t r;
+  for(i = 0; i < SCHEDULER_MAX_TASKS; i++){
+    n = Scheduler_Overruns(i);
+    if((n != Overruns[i]) && !Tripped){
+      Motor_Stop();                    // now, not at the next Motor_Task
+      Tripped = 1;
+      Record_Fault(SUPERVISOR_DEADLINE, i, n - Overruns[i]);
+    }
+    Overruns[i] = n;
+  }
+  WDT_A->CTL = WDT_RUN;
+  Reports--;
+  if(Reports == 0){
+    Reports = SUPERVISOR_REPORT;
+    r.state = SUPERVISOR_RECORD;
+    r.raw = Record.reason;
+    r.bump = Tripped;
+    r.time = WorstMicros();
+    r.position = Scheduler_Late();
+    r.leftDuty = (SysTick->LOAD + 1)/(Clock_GetFreq()/1000000);
+    r.rightDuty = Record.resets;
+    Telemetry_Log(&r);
+  }
+}
+
+// ------------Supervisor_Park------------
+// Hold the watchdog; the tick stops in LPM3.
+// Input: none
+// Output: none
+void Supervisor_Park(void){
+  WDT_A->CTL = WDT_HOLD;
+}
+
+// ------------Supervisor_Tripped------------
+// Input: none
+// Output: 1 if a deadline was missed since reset
+int Supervisor_Tripped(void){
+  return Tripped;
+}
+
+// ------------Supervisor_LastFault------------
+// Input: none
+// Output: record of the last fault
+const Supervisor_Fault_t *Supervisor_LastFault(void){
+  return &Record;
+}
+
+// Any fault: motors off, record, then wait for the watchdog.
+// The watchdog is armed here too, for a fault during boot.
+static void Fault(void){
+  Motor_Stop();
+  Record_Fault(SUPERVISOR_FAULT, 0, SCB->CFSR);
+  Record.pending = 1;
+  SYSCTL->WDTRESET_CTL |= 0x00000001;
+  WDT_A->CTL = WDT_RUN;
+  while(1){}
+}
+
+void HardFault_Handler(void){ Fault(); }
+void MemManage_Handler(void){ Fault(); }
+void BusFault_Handler(void){ Fault(); }
+void UsageFault_Handler(void){ Fault(); }
@@ -0,0 +1,120 @@
+/**
+ * @file      Supervisor.h
+ * @brief     Control loop deadline monitor, watchdog and safe stop
+ * @details   Three layers, from the inside out:<br>
+ 1) Supervisor_Task(), the last task of every tick, compares the
+    scheduler's per-task overrun counters with the last tick. A task
+    that lost a release missed its deadline: the motors stop at once,
+    the FSM goes to Stop (main checks Supervisor_Tripped()) and the
+    reason is recorded.<br>
+ 2) The same task is the only one that restarts WDT_A. If the loop
+    stops running at all (an ISR storm starving main, a task that
+    hangs) the watchdog resets the chip after SUPERVISOR_TIMEOUT_MS,
+    and a hard reset turns the motor drivers off.<br>
+ 3) HardFault, MemManage, BusFault and UsageFault stop the motors,
+    record the fault status and let the watchdog reset the chip.<br>
+ * The record of the last fault is in a NOINIT section, so it survives
+ * the reset it caused; Supervisor_Init() adds the watchdog as the
+ * reason when nothing else was recorded. Once every SUPERVISOR_REPORT
+ * ticks the worst loop time and the counters go out as a telemetry
+ * record with state SUPERVISOR_RECORD:
+<table>
+<caption id="supervisor_report">Report record</caption>
+<tr><th>Field   <th>Contents
+<tr><td>raw     <td>reason of the last fault, enum Supervisor_Reason
+<tr><td>bump    <td>1 if tripped since reset
+<tr><td>time    <td>worst loop time since reset in us (Scheduler_WorstLoop)
+<tr><td>position<td>late loops since reset (Scheduler_Late)
+<tr><td>leftDuty<td>tick period in us
+<tr><td>rightDuty<td>resets caused by the supervisor since power-up
+</table>
+ * @author    Team Donkey Kong
+ * @note      WDT_A runs from BCLK (REFO, set up by Power_Init()) so it
+ * keeps counting in LPM3; call Supervisor_Park() before Power_Deep()
+ ******************************************************************************/
+
+/*!
+ * @defgroup MSP432
+ * @brief
+ * @{*/
+#ifndef SUPERVISOR_H_
+#define SUPERVISOR_H_
+#include <stdint.h>
+
+#define SUPERVISOR_MAGIC      0x53555056  // "SUPV", record valid since power-up
+#define SUPERVISOR_TIMEOUT_MS 16          // watchdog: 2^9 BCLK cycles = 15.6 ms
+#define SUPERVISOR_REPORT     1000        // ticks between report records
+#define SUPERVISOR_RECORD     0xFC        // Telemetry_Record_t state of a report
+
+/**
+ * \brief Why the supervisor stopped the robot
+ */
+enum Supervisor_Reason {
+  SUPERVISOR_NONE,      // nothing recorded since power-up
+  SUPERVISOR_DEADLINE,  // a task lost a release
+  SUPERVISOR_WATCHDOG,  // the loop stopped, WDT_A reset the chip
+  SUPERVISOR_FAULT      // a fault exception, WDT_A reset the chip
+};
+
+/**
+ * \brief Last fault, kept across resets
+ */
+struct Supervisor_Fault {
+  uint32_t magic;       // SUPERVISOR_MAGIC
+  uint8_t reason;       // enum Supervisor_Reason
+  uint8_t task;         // task that missed its deadline
+  uint8_t pending;      // 1 from a fault to the reset it causes
+  uint8_t unused;
+  uint32_t detail;      // overruns of the task, or SCB CFSR of a fault
+  uint32_t tick;        // Scheduler_Ticks() when it happened
+  uint32_t worst;       // worst loop time in us up to then
+  uint32_t resets;      // resets caused by the supervisor since power-up
+};
+typedef struct Supervisor_Fault Supervisor_Fault_t;
+
+/**
+ * Check the cause of this reset, then arm WDT_A.
+ * @param  none
+ * @return none
+ * @note   Call after Power_Init() and right before Scheduler_Start();
+ * from here on Supervisor_Task() must run at least every
+ * SUPERVISOR_TIMEOUT_MS
+ * @brief  Start the supervisor
+ */
+void Supervisor_Init(void);
+
+/**
+ * Check the deadline counters, restart the watchdog and send the
+ * periodic report. Run as the last task, every tick.
+ * @param  none
+ * @return none
+ * @brief  Supervise one tick
+ */
+void Supervisor_Task(void);
+
+/**
+ * Hold the watchdog while parked in LPM3, where the tick stops.
+ * @param  none
+ * @return none
+ * @note   The next Supervisor_Task() arms it again
+ * @brief  Hold the watchdog
+ */
+void Supervisor_Park(void);
+
+/**
+ * Check whether a deadline was missed since reset.
+ * @param  none
+ * @return 1 if the supervisor stopped the motors, 0 if not
+ * @brief  Check for a trip
+ */
+int Supervisor_Tripped(void);
+
+/**
+ * Return the record of the last fault.
+ * @param  none
+ * @return pointer to the record in NOINIT RAM
+ * @brief  Read the fault record
+ */
+const Supervisor_Fault_t *Supervisor_LastFault(void);
+
+#endif /* SUPERVISOR_H_ */
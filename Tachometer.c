@@ -0,0 +1,146 @@
+// Tachometer.c
+// Runs on MSP432
+// Measure wheel speed with TIMER_A3 input capture on the
+// encoder A channels. Each edge stores the period since the
+// previous edge in a small window; the timer overflow counts
+// how long it has been since the last edge so a stopped
+// wheel reads 0 instead of its last speed.
+// Team Donkey Kong
+
+// Right encoder A connected to P10.4 (TA3CCP0)
+// Right encoder B connected to P5.0
+// Left encoder A connected to P10.5 (TA3CCP1)
+// Left encoder B connected to P5.2
+
+#include <stdint.h>
+#include "msp.h"
+#include "Priority.h"
+#include "Tachometer.h"
+#include "Ram.h"
+
+#define RPM10_COUNTS 2500000 // 1.5 MHz*60 s*10/360 steps: speed in 0.1 rpm = this/period
+
+struct Wheel {
+  uint16_t last;                   // capture time of the previous edge
+  uint16_t period[TACH_WINDOW];    // last edge periods in 1/1.5 us
+  uint32_t sum;                    // sum of period[]
+  uint8_t index;                   // next slot in period[]
+  uint8_t overflows;               // timer overflows since the last edge
+  uint8_t valid;                   // number of edges in the window
+  int8_t dir;                      // +1 forward, -1 backward
+  int32_t steps;                   // signed edge count
+};
+static volatile struct Wheel Wheels[2];
+
+// Record one edge of a wheel
+RAMFUNC static void Edge(volatile struct Wheel *w, uint16_t now, int8_t dir){
+  uint16_t period;
+  if(dir != w->dir){
+    w->overflows = 2;              // direction change, old periods are meaningless
+    w->dir = dir;
+  }
+  if(w->overflows > 1){
+    w->valid = 0;                  // too long since the last edge, restart the window
+    w->sum = 0;
+  }
+  else if(w->overflows == 0 || now < w->last){
+    period = now - w->last;        // at most one wrap between edges
+    if(w->valid == TACH_WINDOW){
+      w->sum -= w->period[w->index];
+    }else{
+      w->valid++;
+    }
+    w->period[w->index] = period;
+    w->sum += period;
+    w->index = (w->index + 1)&(TACH_WINDOW-1);
+  }
+  else{
+    w->valid = 0;                  // wrapped past the last edge, period is over 65535
+    w->sum = 0;
+  }
+  w->last = now;
+  w->overflows = 0;
+  w->steps += dir;
+}
+
+// ------------Tachometer_Init------------
+// Initialize the encoder inputs and TIMER_A3 capture.
+// Input: none
+// Output: none
+void Tachometer_Init(void){
+  uint32_t i, j;
+  for(i = 0; i < 2; i++){
+    Wheels[i].last = 0;
+    Wheels[i].sum = 0;
+    Wheels[i].index = 0;
+    Wheels[i].overflows = 2;       // no edge yet
+    Wheels[i].valid = 0;
+    Wheels[i].dir = 1;
+    Wheels[i].steps = 0;
+    for(j = 0; j < TACH_WINDOW; j++){
+      Wheels[i].period[j] = 0;
+    }
+  }
+  P10->SEL0 |= 0x30;
+  P10->SEL1 &= ~0x30;              // P10.5, P10.4 are TA3.1, TA3.0 inputs
+  P10->DIR &= ~0x30;
+  P5->SEL0 &= ~0x05;
+  P5->SEL1 &= ~0x05;               // P5.2, P5.0 are GPIO inputs (encoder B)
+  P5->DIR &= ~0x05;
+  TIMER_A3->CTL &= ~0x0030;        // halt Timer A3
+  TIMER_A3->CTL = 0x02C0;          // SMCLK, divide by 8
+  TIMER_A3->EX0 = 0x0000;          // divide by 1, 1.5 MHz
+  TIMER_A3->CCTL[0] = 0x4910;      // capture rising edge, CCI0A, synchronous, interrupt
+  TIMER_A3->CCTL[1] = 0x4910;      // capture rising edge, CCI1A, synchronous, interrupt
+  NVIC_SetPriority(TA3_0_IRQn, PRIORITY_TACH);
+  NVIC_SetPriority(TA3_N_IRQn, PRIORITY_TACH);
+  NVIC_EnableIRQ(TA3_0_IRQn);
+  NVIC_EnableIRQ(TA3_N_IRQn);
+  TIMER_A3->CTL |= 0x0026;         // reset and start in continuous mode, overflow interrupt
+}
+
+// Right encoder edge (CCR0)
+RAMFUNC void TA3_0_IRQHandler(void){
+  TIMER_A3->CCTL[0] &= ~0x0001;    // acknowledge capture
+  Edge(&Wheels[TACH_RIGHT], TIMER_A3->CCR[0], (P5->IN&0x01)? -1 : 1);
+}
+
+// Left encoder edge (CCR1) and timer overflow
+RAMFUNC void TA3_N_IRQHandler(void){
+  switch(TIMER_A3->IV){            // reading IV clears the highest pending flag
+  case 0x02:                       // CCR1
+    Edge(&Wheels[TACH_LEFT], TIMER_A3->CCR[1], (P5->IN&0x04)? 1 : -1);
+    break;
+  case 0x0E:                       // overflow, every 43.7 ms
+    if(Wheels[0].overflows < 255) Wheels[0].overflows++;
+    if(Wheels[1].overflows < 255) Wheels[1].overflows++;
+    break;
+  default:
+    break;
+  }
+}
+
+// ------------Tachometer_Speed------------
+// Return the averaged speed of one wheel.
+// Input: wheel  TACH_LEFT or TACH_RIGHT
+// Output: speed in 0.1 rpm, positive forward, 0 if stopped
+int32_t Tachometer_Speed(uint32_t wheel){
+  volatile struct Wheel *w = &Wheels[wheel&1];
+  uint32_t sum, valid;
+  int32_t dir;
+  sum = w->sum;                    // a capture can land between these reads;
+  valid = w->valid;                // that costs one edge of accuracy, no more
+  dir = w->dir;
+  if((w->overflows > 1) || (valid == 0) || (sum == 0)){
+    return 0;
+  }
+  return dir*(int32_t)((RPM10_COUNTS*valid)/sum);
+}
+
+// ------------Tachometer_Steps------------
+// Return the signed step count of one wheel.
+// Input: wheel  TACH_LEFT or TACH_RIGHT
+// Output: steps since Tachometer_Init(), positive forward
+int32_t Tachometer_Steps(uint32_t wheel){
+  return Wheels[wheel&1].steps;
+}
@@ -0,0 +1,60 @@
+/**
+ * @file      Tachometer.h
+ * @brief     Wheel encoder capture and speed measurement
+ * @details   TIMER_A3 captures the rising edges of encoder channel A of
+ * each wheel with no polling; channel B is read in the capture ISR to
+ * get the direction. Speed is averaged over the last TACH_WINDOW edge
+ * periods. The encoders give 360 edges per wheel revolution.<br>
+<table>
+<caption id="tach_pins">Encoder connections</caption>
+<tr><th>Pin   <th>Function
+<tr><td>P10.4 <td>Right encoder A, TA3CCP0
+<tr><td>P5.0  <td>Right encoder B
+<tr><td>P10.5 <td>Left encoder A, TA3CCP1
+<tr><td>P5.2  <td>Left encoder B
+</table>
+ * @author    Team Donkey Kong
+ * @note      TIMER_A3 runs at SMCLK/8 = 1.5 MHz; the slowest measurable
+ * speed is about 4 rpm, anything slower reads 0
+ ******************************************************************************/
+
+/*!
+ * @defgroup RSLK_Input_Output
+ * @brief
+ * @{*/
+#ifndef TACHOMETER_H_
+#define TACHOMETER_H_
+#include <stdint.h>
+
+#define TACH_LEFT   0       // wheel index of the left wheel
+#define TACH_RIGHT  1       // wheel index of the right wheel
+#define TACH_WINDOW 8       // edge periods averaged, power of 2
+#define TACH_STEPS_PER_REV 360
+#define TACH_UM_PER_STEP 611  // 70 mm wheel: 219.9 mm / 360 steps, in um
+
+/**
+ * Initialize the encoder inputs and TIMER_A3 input capture.
+ * @param  none
+ * @return none
+ * @note   Assumes Clock_Init48MHz() has been called (SMCLK = 12 MHz)
+ * @brief  Initialize the tachometer
+ */
+void Tachometer_Init(void);
+
+/**
+ * Return the speed of one wheel.
+ * @param  wheel TACH_LEFT or TACH_RIGHT
+ * @return speed in 0.1 rpm, positive forward, 0 when stopped
+ * @brief  Wheel speed
+ */
+int32_t Tachometer_Speed(uint32_t wheel);
+
+/**
+ * Return the signed number of encoder steps since Tachometer_Init().
+ * @param  wheel TACH_LEFT or TACH_RIGHT
+ * @return steps, positive forward, 360 per revolution
+ * @brief  Wheel position
+ */
+int32_t Tachometer_Steps(uint32_t wheel);
+
+#endif /* TACHOMETER_H_ */
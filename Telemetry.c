@@ -0,0 +1,126 @@
+// Telemetry.c
+// Runs on MSP432
+// Lock-free ring buffer of telemetry records, drained to
+// UART0 (eUSCI_A0, P1.3 TX) by uDMA channel 0.
+// The producer only writes Head, the DMA completion ISR
+// only writes Tail. The DMA always sends one contiguous run
+// of records, from Tail up to Head or the end of the buffer.
+// Team Donkey Kong
+
+#include <stdint.h>
+#include "msp.h"
+#include "Priority.h"
+#include "CortexM.h"
+#include "Telemetry.h"
+
+#define MASK (TELEMETRY_RECORDS-1)
+
+static Telemetry_Record_t Buffer[TELEMETRY_RECORDS];
+static volatile uint32_t Head = 0;   // next record to write
+static volatile uint32_t Tail = 0;   // next record to send
+static volatile uint32_t Chunk = 0;  // records in the transfer in flight, 0 if idle
+static uint32_t Dropped = 0;
+
+// uDMA control table, primary and alternate structures for 8 channels.
+// Must be aligned to its size. Each entry is source end pointer,
+// destination end pointer, control word, unused.
+#pragma DATA_ALIGN(DMAControlTable, 256)
+static uint32_t DMAControlTable[64];
+
+// Start a transfer of the next contiguous run of records.
+// Assumes: interrupts are disabled or called from the DMA ISR
+static void StartTransfer(void){
+  uint32_t head = Head, tail = Tail, count, bytes;
+  if(Chunk || (head == tail)){
+    return;                            // busy, or nothing to send
+  }
+  count = (head > tail)? (head - tail) : (TELEMETRY_RECORDS - tail);
+  bytes = count*sizeof(Telemetry_Record_t);
+  DMAControlTable[0] = (uint32_t)((uint8_t *)&Buffer[tail] + bytes - 1); // source end
+  DMAControlTable[1] = (uint32_t)&EUSCI_A0->TXBUF;                         // destination end
+  DMAControlTable[2] = 0xC0000000 |    // destination fixed, byte
+                       ((bytes-1)<<4)| // N-1 transfers
+                       0x00000001;     // basic mode, one byte per request
+  Chunk = count;
+  DMA_Control->ENASET = 0x00000001;    // enable channel 0
+  if(EUSCI_A0->IFG&0x02){
+    EUSCI_A0->IFG &= ~0x02;            // TX already idle: make a fresh
+    EUSCI_A0->IFG |= 0x02;             // TXIFG edge to trigger the first byte
+  }
+}
+
+// ------------Telemetry_Init------------
+// Initialize eUSCI_A0 at 460800 baud and uDMA channel 0.
+// Input: none
+// Output: none
+// Assumes: SMCLK is 12 MHz
+void Telemetry_Init(void){
+  EUSCI_A0->CTLW0 = 0x0001;            // hold the USCI module in reset mode
+  EUSCI_A0->CTLW0 = 0x00C1;            // 8-N-1, SMCLK, still in reset
+  EUSCI_A0->BRW = 1;                   // 12,000,000/16/460800 = 1.63
+  EUSCI_A0->MCTLW = 0x00A1;            // UCBRS=0, UCBRF=10, UCOS16=1
+  P1->SEL0 |= 0x0C;
+  P1->SEL1 &= ~0x0C;                   // configure P1.3 and P1.2 as primary module function
+  EUSCI_A0->CTLW0 &= ~0x0001;          // enable the USCI module
+  EUSCI_A0->IE &= ~0x000F;             // no UART interrupts, the DMA owns TXIFG
+
+  Head = Tail = Chunk = 0;
+  Dropped = 0;
+  DMA_Control->CFG = 0x00000001;       // enable the uDMA controller
+  DMA_Control->CTLBASE = (uint32_t)DMAControlTable;
+  DMA_Channel->CH_SRCCFG[0] = 1;       // channel 0 triggered by eUSCI_A0 TX
+  DMA_Control->ALTCLR = 0x00000001;    // use the primary structure
+  DMA_Control->PRIOCLR = 0x00000001;   // default priority
+  DMA_Control->USEBURSTCLR = 0x00000001;
+  DMA_Control->REQMASKCLR = 0x00000001;
+  DMA_Channel->INT1_SRCCFG = 0x20|0;   // DMA_INT1 on completion of channel 0
+  NVIC_SetPriority(DMA_INT1_IRQn, PRIORITY_TELEMETRY);
+  NVIC_EnableIRQ(DMA_INT1_IRQn);
+}
+
+// Channel 0 finished a run of records
+void DMA_INT1_IRQHandler(void){
+  Tail = (Tail + Chunk)&MASK;          // INT1 flag clears on entry
+  Chunk = 0;
+  StartTransfer();
+}
+
+// ------------Telemetry_Log------------
+// Copy one record into the ring buffer and start the DMA
+// if it is idle. Never blocks.
+// Input: record  record to queue
+// Output: 1 if queued, 0 if the buffer was full
+int Telemetry_Log(const Telemetry_Record_t *record){
+  uint32_t head = Head, next;
+  uint32_t sr;
+  next = (head + 1)&MASK;
+  if(next == Tail){
+    Dropped = Dropped + 1;             // full, keep the older records
+    return 0;
+  }
+  Buffer[head] = *record;
+  Buffer[head].sync = TELEMETRY_SYNC;
+  Head = next;                         // publish
+  if(Chunk == 0){
+    sr = StartMasked();                // only races the DMA ISR
+    StartTransfer();
+    EndMasked(sr);
+  }
+  return 1;
+}
+
+// ------------Telemetry_Dropped------------
+// Return the number of records dropped.
+// Input: none
+// Output: dropped record count
+uint32_t Telemetry_Dropped(void){
+  return Dropped;
+}
+
+// ------------Telemetry_Busy------------
+// Check whether records are still queued or being sent.
+// Input: none
+// Output: 1 if the ring, the DMA or the UART is busy, 0 if idle
+int Telemetry_Busy(void){
+  return (Head != Tail) || Chunk || (EUSCI_A0->STATW&0x0001);
+}
@@ -0,0 +1,90 @@
+/**
+ * @file      Telemetry.h
+ * @brief     Binary telemetry stream over UART0 with uDMA
+ * @details   The control loop writes fixed 16-byte records into a
+ * lock-free single-producer ring buffer. uDMA channel 0 drains the
+ * buffer into eUSCI_A0 (P1.3 TX, the LaunchPad back-channel UART) at
+ * 460800 baud, 8-N-1, so the CPU only touches each record once.
+ * At 16 bytes per record the link carries about 2800 records/s.<br>
+ * Record layout, little endian:
+<table>
+<caption id="telemetry_record">Telemetry record</caption>
+<tr><th>Offset<th>Size<th>Field
+<tr><td>0 <td>1<td>sync, always TELEMETRY_SYNC
+<tr><td>1 <td>1<td>FSM state index; PARAM_RECORD for a parameter reply, TRACKMAP_RECORD for a map segment
+<tr><td>2 <td>1<td>raw reflectance bits
+<tr><td>3 <td>1<td>bump bits
+<tr><td>4 <td>4<td>timestamp in us (Clock_Micros)
+<tr><td>8 <td>4<td>line position (Reflectance_Position)
+<tr><td>12<td>2<td>left duty
+<tr><td>14<td>2<td>right duty
+</table>
+ * @author    Team Donkey Kong
+ * @note      Uses eUSCI_A0, uDMA channel 0 and DMA_INT1
+ ******************************************************************************/
+
+/*!
+ * @defgroup RSLK_Input_Output
+ * @brief
+ * @{*/
+#ifndef TELEMETRY_H_
+#define TELEMETRY_H_
+#include <stdint.h>
+
+#define TELEMETRY_SYNC    0xA5  // first byte of every record
+#define TELEMETRY_RECORDS 64    // ring buffer size in records, power of 2
+
+/**
+ * \brief One 16-byte telemetry record
+ */
+struct Telemetry_Record {
+  uint8_t sync;        // TELEMETRY_SYNC
+  uint8_t state;       // FSM state index
+  uint8_t raw;         // raw reflectance bits
+  uint8_t bump;        // bump bits
+  uint32_t time;       // timestamp in us
+  int32_t position;    // line position
+  uint16_t leftDuty;   // left motor duty
+  uint16_t rightDuty;  // right motor duty
+};
+typedef struct Telemetry_Record Telemetry_Record_t;
+
+/**
+ * Initialize eUSCI_A0 for 460800 baud from SMCLK = 12 MHz and
+ * set up uDMA channel 0 to drain the ring buffer.
+ * @param  none
+ * @return none
+ * @note   Assumes Clock_Init48MHz() has been called
+ * @brief  Initialize telemetry
+ */
+void Telemetry_Init(void);
+
+/**
+ * Copy one record into the ring buffer and start the DMA if it is idle.
+ * Never blocks; if the buffer is full the record is dropped and counted.
+ * The sync byte is filled in here.
+ * @param  record record to send
+ * @return 1 if queued, 0 if dropped
+ * @note   Single producer: call from one context only
+ * @brief  Queue a telemetry record
+ */
+int Telemetry_Log(const Telemetry_Record_t *record);
+
+/**
+ * Return the number of records dropped because the buffer was full.
+ * @param  none
+ * @return dropped record count
+ * @brief  Count of dropped records
+ */
+uint32_t Telemetry_Dropped(void);
+
+/**
+ * Check whether any record is still queued or on the wire.
+ * @param  none
+ * @return 1 if busy, 0 once the last byte has left the UART
+ * @note   The UART stops in LPM3, so wait for 0 before Power_Deep()
+ * @brief  Telemetry busy
+ */
+int Telemetry_Busy(void);
+
+#endif /* TELEMETRY_H_ */
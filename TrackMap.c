@@ -0,0 +1,204 @@
+// TrackMap.c
+// Runs on MSP432 and on the host (sim/)
+// Segment map of one lap learned between two start/finish
+// markers, the speed plan built from it, and the lookup
+// used on the racing laps.
+// Team Donkey Kong
+
+#include <stdint.h>
+#include "FixedPoint.h"
+#include "Motor.h"
+#include "Reflectance.h"
+#include "Curve.h"              // CURVE_STRAIGHT, CURVE_CURVED
+#include "TrackMap.h"
+#include "Ram.h"
+
+// Start learning from segment 0
+static void StartLearning(TrackMap_t *map){
+  map->phase = TRACKMAP_LEARN;
+  map->current = 0;
+  map->sumPosition = 0;
+  map->sumTurn = 0;
+  map->steps = 0;
+  map->hard = 0;
+}
+
+// Store the averages of the segment being learned
+static void Store(TrackMap_t *map){
+  TrackMap_Segment_t *seg = &map->segment[map->current];
+  if(map->steps == 0){                  // passed through without a step
+    if(map->current){
+      *seg = map->segment[map->current - 1];
+    }else{
+      seg->position = seg->turn = 0;
+      seg->hard = seg->steps = 0;
+      seg->speed = TRACKMAP_SPEED_ONE;
+      seg->steer = 0;
+    }
+    return;
+  }
+  seg->position = map->sumPosition/(int32_t)map->steps/4;
+  seg->turn = map->sumTurn/(int32_t)map->steps;
+  seg->hard = (map->hard > 255)? 255 : map->hard;
+  seg->steps = (map->steps > 255)? 255 : map->steps;
+  seg->speed = TRACKMAP_SPEED_ONE;
+  seg->steer = 0;
+}
+
+// A marker was seen, along mm after the previous one
+static void Marker(TrackMap_t *map, int32_t distance, int32_t along){
+  map->laps++;
+  map->lapStart = distance;
+  switch(map->phase){
+  case TRACKMAP_LEARN:
+    Store(map);
+    map->count = map->current + 1;
+    map->lapMm = along;
+    TrackMap_Plan(map);
+    map->phase = TRACKMAP_RACE;
+    break;
+  case TRACKMAP_RACE:
+    if((along > map->lapMm + map->lapMm/8) || (along < map->lapMm - map->lapMm/8)){
+      StartLearning(map);               // cut a corner, missed a marker, new track
+    }
+    break;
+  default:
+    StartLearning(map);
+    break;
+  }
+}
+
+// ------------TrackMap_Init------------
+// Empty map, waiting for the first marker.
+// Input: map  track map
+// Output: none
+void TrackMap_Init(TrackMap_t *map){
+  map->count = 0;
+  map->lapMm = 0;
+  map->lapStart = 0;
+  map->phase = TRACKMAP_WAIT;
+  map->black = 0;
+  map->laps = 0;
+  map->current = 0;
+  map->scale = FX_Q16_ONE;
+  map->steer = 0;
+}
+
+// ------------TrackMap_Step------------
+// Count all-black steps for the marker, then learn the
+// current segment or look up the one ahead.
+// Input: map       track map
+//        distance  wheel distance in mm
+//        data      raw sensor sample
+//        position  estimated line position or REFLECTANCE_LOST
+//        command   MOTOR_CMD() word of this step
+// Output: 1 while racing, 0 otherwise
+RAMFUNC int TrackMap_Step(TrackMap_t *map, int32_t distance, uint8_t data, int32_t position, uint32_t command){
+  TrackMap_Segment_t *seg;
+  int32_t along = distance - map->lapStart;
+  uint32_t i;
+  if(data == 0xFF){
+    if(map->black < 255) map->black++;
+  }else{
+    map->black = 0;
+  }
+  if((map->black == TRACKMAP_MARKER) && ((map->laps == 0) || (along > TRACKMAP_REARM_MM))){
+    Marker(map, distance, along);
+    along = 0;
+  }
+  if(along < 0){
+    along = 0;                          // backed up over the marker
+  }
+  if(map->phase == TRACKMAP_LEARN){
+    i = along/TRACKMAP_SEGMENT_MM;
+    while(map->current < i){
+      Store(map);
+      map->current++;
+      map->sumPosition = map->sumTurn = 0;
+      map->steps = map->hard = 0;
+      if(map->current >= TRACKMAP_SEGMENTS){
+        map->phase = TRACKMAP_WAIT;     // lap too long for the map
+        return 0;
+      }
+    }
+    if(position == REFLECTANCE_LOST){
+      map->hard++;
+    }else{
+      map->sumPosition += position;
+    }
+    if(MOTOR_CMD_DIR(command) != MOTOR_DIR_FORWARD){
+      map->hard++;
+    }
+    map->sumTurn += MOTOR_CMD_RIGHT_SIGNED(command) - MOTOR_CMD_LEFT_SIGNED(command);
+    map->steps++;
+    return 0;
+  }
+  if(map->phase == TRACKMAP_RACE){
+    i = ((uint32_t)(along + TRACKMAP_LOOKAHEAD_MM)/TRACKMAP_SEGMENT_MM)%map->count;
+    seg = &map->segment[i];
+    map->current = i;
+    map->scale = (q16_t)seg->speed<<10;  // 64 -> 65536
+    map->steer = seg->steer*64;
+    return 1;
+  }
+  return 0;
+}
+
+// ------------TrackMap_Plan------------
+// Speed limit of every segment from its turn and hard count,
+// then braking and acceleration limits applied around the
+// lap (twice, since the lap is a loop). The feedforward is
+// half the learned turn; the FSM corrects the rest.
+// Input: map  track map with count segments
+// Output: none
+void TrackMap_Plan(TrackMap_t *map){
+  TrackMap_Segment_t *seg = map->segment;
+  uint32_t n = map->count, i, j, k;
+  int32_t turn;
+  for(i = 0; i < n; i++){
+    turn = seg[i].turn;
+    if(turn < 0) turn = -turn;
+    if(2*(uint32_t)seg[i].hard > seg[i].steps){
+      seg[i].speed = TRACKMAP_SLOW;
+    }else if((seg[i].hard == 0) && (turn < CURVE_STRAIGHT)){
+      seg[i].speed = TRACKMAP_FAST;
+    }else if(turn < CURVE_CURVED){
+      seg[i].speed = TRACKMAP_EASY;
+    }else{
+      seg[i].speed = TRACKMAP_SPEED_ONE;
+    }
+    seg[i].steer = (int8_t)FX_Clamp(seg[i].turn/128, -127, 127);
+  }
+  for(k = 2*n; k > 0; k--){             // braking: look at the next segment
+    i = (k - 1)%n;
+    j = (i + 1)%n;
+    if(seg[i].speed > seg[j].speed + TRACKMAP_DECEL){
+      seg[i].speed = seg[j].speed + TRACKMAP_DECEL;
+    }
+  }
+  for(k = 0; k < 2*n; k++){             // acceleration: look at the previous one
+    i = k%n;
+    j = (i + n - 1)%n;
+    if(seg[i].speed > seg[j].speed + TRACKMAP_ACCEL){
+      seg[i].speed = seg[j].speed + TRACKMAP_ACCEL;
+    }
+  }
+}
+
+// ------------TrackMap_Apply------------
+// Scale both duties and add the feedforward turn, half to
+// each wheel. A command with a reversed wheel (hard turn,
+// Lost) or both duties 0 (Stop) is only scaled.
+// Input: map      track map
+//        command  MOTOR_CMD() word at scale 1.0
+// Output: raced MOTOR_CMD() word
+RAMFUNC uint32_t TrackMap_Apply(const TrackMap_t *map, uint32_t command){
+  int32_t left = MOTOR_CMD_LEFT(command), right = MOTOR_CMD_RIGHT(command);
+  left = FX_MulQ16(map->scale, left);
+  right = FX_MulQ16(map->scale, right);
+  if((MOTOR_CMD_DIR(command) == MOTOR_DIR_FORWARD) && (left || right)){
+    left -= map->steer/2;
+    right += map->steer/2;
+  }
+  return MOTOR_CMD(MOTOR_CMD_DIR(command), FX_ClampDuty(left), FX_ClampDuty(right));
+}
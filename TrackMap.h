@@ -0,0 +1,129 @@
+/**
+ * @file      TrackMap.h
+ * @brief     Learn one lap as a segment map, then race a planned speed profile
+ * @details   The lap is cut into TRACKMAP_SEGMENT_MM pieces of wheel
+ * distance (from the encoders). A start/finish marker across the track
+ * (all eight sensors black for TRACKMAP_MARKER steps) closes a lap.<br>
+ 1) TRACKMAP_WAIT: drive on the Curve.c schedule until the first marker<br>
+ 2) TRACKMAP_LEARN: one lap, averaging the line position and the turn of
+    the motor command (right minus left duty) of every segment, and
+    counting hard turns (a wheel reversed) and lost-line steps<br>
+ 3) at the next marker TrackMap_Plan() turns the map into a speed and a
+    steering feedforward per segment: fast on straights, back to 1.0 in
+    curves and wherever a wheel reversed, slower where that was most of
+    the segment, then a backward pass so braking starts TRACKMAP_DECEL
+    per segment before a slow segment and a forward pass that limits
+    acceleration<br>
+ 4) TRACKMAP_RACE: every step looks up the segment TRACKMAP_LOOKAHEAD_MM
+    ahead and applies its speed and feedforward to the FSM command<br>
+ * Every marker re-aligns the distance. A lap whose length is more than
+ * 1/8 off the learned one drops the map and learns again.<br>
+ * Storage is fixed: TRACKMAP_SEGMENTS of 8 bytes (4 KB, a 10 m lap).
+ * @author    Team Donkey Kong
+ * @note      Hardware independent, also built by the host simulator
+ ******************************************************************************/
+
+/*!
+ * @defgroup RSLK_Control
+ * @brief
+ * @{*/
+#ifndef TRACKMAP_H_
+#define TRACKMAP_H_
+#include <stdint.h>
+#include "FixedPoint.h"
+
+#define TRACKMAP_SEGMENTS    512   // segments in the map, 4 KB
+#define TRACKMAP_SEGMENT_MM  20    // wheel distance per segment
+#define TRACKMAP_MARKER      8     // all-black steps that make a marker
+#define TRACKMAP_REARM_MM    300   // distance after a marker before the next one counts
+#ifndef TRACKMAP_LOOKAHEAD_MM
+#define TRACKMAP_LOOKAHEAD_MM 40   // look up this far ahead of the axle (motor lag)
+#endif
+#define TRACKMAP_SPEED_ONE   64    // speed 1.0 in map units
+#ifndef TRACKMAP_FAST
+#define TRACKMAP_FAST        96    // 1.5 on a straight
+#endif
+#define TRACKMAP_EASY        80    // 1.25 in a gentle curve
+#define TRACKMAP_SLOW        56    // 0.875 where most steps lost the line or reversed a wheel
+#define TRACKMAP_DECEL       6     // speed units lost per segment when braking
+#define TRACKMAP_ACCEL       4     // speed units gained per segment when accelerating
+#define TRACKMAP_RECORD      0xFE  // Telemetry_Record_t state of an exported segment
+
+/**
+ * \brief Phase of the map
+ */
+enum TrackMap_Phase { TRACKMAP_WAIT, TRACKMAP_LEARN, TRACKMAP_RACE };
+
+/**
+ * \brief One segment of the lap
+ */
+struct TrackMap_Segment {
+  int16_t position;    // mean line position/4
+  int16_t turn;        // mean command turn, duty
+  uint8_t hard;        // steps with a reversed wheel or no line, saturating
+  uint8_t steps;       // control steps spent in the segment, saturating
+  uint8_t speed;       // planned speed, TRACKMAP_SPEED_ONE = 1.0
+  int8_t steer;        // planned feedforward turn, duty/64
+};
+typedef struct TrackMap_Segment TrackMap_Segment_t;
+
+/**
+ * \brief A map and its learning and racing state
+ */
+struct TrackMap {
+  TrackMap_Segment_t segment[TRACKMAP_SEGMENTS];
+  uint32_t count;      // segments in the learned lap
+  int32_t lapMm;       // learned lap length
+  int32_t lapStart;    // wheel distance at the last marker
+  uint8_t phase;       // enum TrackMap_Phase
+  uint8_t black;       // consecutive all-black steps
+  uint16_t laps;       // markers seen
+  int32_t sumPosition; // accumulators of the segment being learned
+  int32_t sumTurn;
+  uint32_t steps;
+  uint32_t hard;
+  uint32_t current;    // segment being learned or raced
+  q16_t scale;         // speed scale in use while racing
+  int32_t steer;       // feedforward turn in use while racing, duty
+};
+typedef struct TrackMap TrackMap_t;
+
+/**
+ * Forget the map and wait for the first marker.
+ * @param  map track map
+ * @return none
+ * @brief  Reset the map
+ */
+void TrackMap_Init(TrackMap_t *map);
+
+/**
+ * Run one control step: watch for the marker, learn or look up.
+ * @param  map track map
+ * @param  distance wheel distance travelled in mm, from any origin
+ * @param  data raw sensor sample (for the marker)
+ * @param  position estimated line position, REFLECTANCE_LOST if lost
+ * @param  command MOTOR_CMD() word chosen this step, before scheduling
+ * @return 1 if racing (use TrackMap_Apply()), 0 if not
+ * @brief  Step the map
+ */
+int TrackMap_Step(TrackMap_t *map, int32_t distance, uint8_t data, int32_t position, uint32_t command);
+
+/**
+ * Build the speed and steering plan from a learned lap.
+ * @param  map track map with count segments learned
+ * @return none
+ * @note   Called by TrackMap_Step() at the end of the learning lap
+ * @brief  Plan the racing laps
+ */
+void TrackMap_Plan(TrackMap_t *map);
+
+/**
+ * Apply the racing speed and feedforward to a motor command.
+ * @param  map track map in TRACKMAP_RACE
+ * @param  command MOTOR_CMD() word at scale 1.0
+ * @return scaled command; the feedforward is only added when both wheels go forward
+ * @brief  Race a command
+ */
+uint32_t TrackMap_Apply(const TrackMap_t *map, uint32_t command);
+
+#endif /* TRACKMAP_H_ */
@@ -0,0 +1,60 @@
+/******************************************************************************
+* msp432p401r.cmd
+* Linker command file for the MSP432P401R, TI Arm compiler 15.9.0 or later
+*
+* SRAM is partitioned instead of aliased: the first RAM_CODE_SIZE bytes are
+* used through the code-bus alias at 0x01000000 for functions marked RAMFUNC
+* (Ram.h) and the relocated vector table, the rest through 0x20000000 for
+* data and the stack. Code run from SRAM_CODE has no flash wait states and
+* its fetches do not compete with data on the system bus.
+*
+* Large constant tables (FSM tables, PositionTable) stay in .const in MAIN.
+* The last 4 KB flash sector (bank 1 sector 31) is kept out of MAIN for the
+* reflectance calibration profile written at run time (Calibrate.c).
+* Team Donkey Kong
+******************************************************************************/
+
+#define RAM_CODE_SIZE 0x00002000    /* 8 KB of the 64 KB SRAM for code */
+
+MEMORY
+{
+    MAIN       (RX) : origin = 0x00000000, length = 0x0003F000
+    CALIB      (R)  : origin = 0x0003F000, length = 0x00001000
+    INFO       (RX) : origin = 0x00200000, length = 0x00004000
+    SRAM_CODE  (RWX): origin = 0x01000000, length = RAM_CODE_SIZE
+    SRAM_DATA  (RW) : origin = 0x20000000 + RAM_CODE_SIZE, length = 0x00010000 - RAM_CODE_SIZE
+}
+
+/* Stack and heap sizes are set in the CCS project (512 and 1024 bytes).   */
+
+SECTIONS
+{
+    .intvecs:   > 0x00000000
+    .text   :   > MAIN
+    .const  :   > MAIN
+    .cinit  :   > MAIN
+    .pinit  :   > MAIN
+    .init_array   :     > MAIN
+    .binit        : {}  > MAIN
+
+    /* TLV table for device identification and characterization            */
+    .tlvTable     : > 0x00201000
+    /* BSL area for device bootstrap loader                                */
+    .bslArea      : > 0x00202000
+
+    /* RAMFUNC code: stored in flash, copied to SRAM by the boot routine   */
+    /* through the .binit copy table before main() runs                    */
+    .TI.ramfunc : {} load=MAIN, run=SRAM_CODE, table(BINIT)
+
+    /* RAM vector table, filled by Ram_Init(), not initialized by cinit    */
+    .vtable : > SRAM_CODE, type = NOINIT
+
+    .data   :   > SRAM_DATA
+    .bss    :   > SRAM_DATA
+    .TI.noinit  : > SRAM_DATA
+    .sysmem :   > SRAM_DATA
+    .stack  :   > SRAM_DATA (HIGH)
+}
+
+/* Symbolic definition of the WDTCTL register for RTS */
+WDTCTL_SYM = 0x4000480C;
@@ -0,0 +1,315 @@
+// Sim.c
+// Runs on the host
+// Line follower simulator: runs the real FSM.c and Position.c
+// against the kinematic model in Track.c, on the same 1 ms tick,
+// 1.1 ms sensor frame and 10 ms motor update as JackiFSMmain.c,
+// or replays a telemetry trace recorded on the robot.
+// Prints the lap times and a benchmark of the FSM step.
+// The motor ramp is Motor_Ramp() from Motor.h; the battery is not
+// modelled, the pack is always at BATTERY_NOMINAL_MV.
+// Team Donkey Kong
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <math.h>
+#include "FixedPoint.h"
+#include "Motor.h"
+#include "Reflectance.h"
+#include "FSM.h"
+#include "Telemetry.h"
+#include "Curve.h"
+#include "TrackMap.h"
+#include "Track.h"
+
+#define TICK_US        1000   // scheduler tick, as TICK_RATE in main
+#define SAMPLE_US      1100   // sensor frame at the default 1000 us sample time
+#define MOTOR_PERIOD     10   // ticks between motor updates
+#define PWM_US        20000   // PWM period, the ramp runs once per period
+#define DERAIL_MM     150.0   // sensor bar this far from the line ends the run
+#define BENCH_STEPS 20000000  // FSM_Step calls timed by the benchmark
+
+static const char *StateName[FSM_NUM_STATES] = {
+#define FSM_NAME(name,l,r,dwell,dir,n0,n1,n2,n3,n4,n5,bump,timeout,timer) #name,
+  FSM_TABLE(FSM_NAME)
+#undef FSM_NAME
+};
+
+static double Seconds(void){
+  return (double)clock()/CLOCKS_PER_SEC;
+}
+
+struct Result {
+  int laps;                 // laps completed
+  double lap[16];           // time of each lap in s
+  double worst;             // largest distance of the bar from the line, mm
+  uint32_t ticks;           // ticks simulated
+  uint32_t changes;         // FSM transitions
+  uint32_t lost;            // ticks spent in L_Lost or R_Lost
+  uint32_t straight;        // ticks classed as straight by Curve.c
+  uint32_t braking;         // ticks braking for a predicted curve
+  uint32_t racing;          // ticks on the TrackMap.c plan
+  uint32_t segments;        // segments in the learned map
+  int derailed;             // 1 if the run ended off the track
+};
+
+// ------------Simulate------------
+// Drive laps of the track with the FSM in the loop.
+// Input: t        track
+//        laps     laps to drive, at most 16
+//        timeout  longest run in s of simulated time
+//        dropout  per mille of sensor frames replaced by 0
+//        schedule 1 to scale the FSM duties with Curve.c
+//        map      1 to race the TrackMap.c plan once a lap is learned
+//        res      filled with the result
+// Output: none
+static void Simulate(const Track_t *t, int laps, double timeout, int dropout, int schedule, int map, struct Result *res){
+  static Curve_t curve;
+  static TrackMap_t trackMap;
+  FSM_t fsm;
+  Robot_t robot;
+  uint32_t now = 0, nextFrame = SAMPLE_US, nextPwm = PWM_US, pending;
+  uint32_t limit = (uint32_t)(timeout*1000000.0);
+  int32_t left = 0, right = 0, targetL = 0, targetR = 0;
+  double length = Track_Length(t), lapStart = 0.0, d;
+  uint8_t frame = 0;
+  int racing = 0;
+
+  memset(res, 0, sizeof(*res));
+  srand(1);                     // same dropouts on every run
+  Track_Start(t, &robot);
+  FSM_Init(&fsm, L_Center);
+  Curve_Init(&curve);
+  TrackMap_Init(&trackMap);
+  frame = Track_Sense(t, &robot);
+  pending = fsm.command;
+  while((res->laps < laps) && (now < limit)){
+    now += TICK_US;
+    Track_Move(t, &robot, left, right, TICK_US/1000000.0);
+    while(nextFrame <= now){    // acquisition engine, not locked to the tick
+      frame = Track_Sense(t, &robot);
+      if((rand()%1000) < dropout){
+        frame = 0;              // glare, a gap in the tape, a dirty sensor
+      }
+      nextFrame += SAMPLE_US;
+    }
+    res->changes += FSM_Step(&fsm, frame);
+    Curve_Update(&curve, fsm.position, fsm.estimate.velocity, fsm.command);
+    res->straight += (curve.type == CURVE_CLASS_STRAIGHT);
+    res->braking += (curve.type == CURVE_CLASS_BRAKE);
+    if(map){
+      racing = TrackMap_Step(&trackMap, (int32_t)robot.odometer, frame, fsm.position, fsm.command);
+      res->racing += racing;
+    }
+    if((fsm.state == L_Lost) || (fsm.state == R_Lost)){
+      res->lost++;
+    }
+    res->ticks++;
+    if((res->ticks%MOTOR_PERIOD) == 0){
+      if(racing){                                                         // Motor_Task
+        pending = TrackMap_Apply(&trackMap, fsm.command);
+      }else{
+        pending = schedule? Curve_Apply(&curve, fsm.command) : fsm.command;
+      }
+    }
+    if(nextPwm <= now){         // TA0 CCR0 ISR, always on a pack at BATTERY_NOMINAL_MV:
+                                // Battery_Scale() 1.0, Battery_Low() 0, so no MOTOR_SLEW_LOW
+      targetL = MOTOR_CMD_LEFT(pending);
+      targetR = MOTOR_CMD_RIGHT(pending);
+      if(pending&0x10000000) targetL = -targetL;
+      if(pending&0x20000000) targetR = -targetR;
+      left = Motor_Ramp(left, targetL, MOTOR_SLEW_DEFAULT);
+      right = Motor_Ramp(right, targetR, MOTOR_SLEW_DEFAULT);
+      nextPwm += PWM_US;
+    }
+    d = Track_Distance(t, robot.x + TRACK_BAR_AHEAD*cos(robot.heading),
+                          robot.y + TRACK_BAR_AHEAD*sin(robot.heading));
+    if(d > res->worst){
+      res->worst = d;
+    }
+    if((d > DERAIL_MM) || (robot.progress < -DERAIL_MM)){
+      res->derailed = 1;
+      return;
+    }
+    if(robot.progress >= (res->laps + 1)*length){
+      res->lap[res->laps] = now/1000000.0 - lapStart;
+      lapStart = now/1000000.0;
+      res->laps++;
+    }
+  }
+  res->segments = trackMap.count;
+}
+
+// ------------Replay------------
+// Feed the raw samples of a recorded trace to FSM_Step() and
+// compare the state after each step with the recorded state.
+// Records are logged once per tick after FSM_Task, and raw is
+// the sample that tick's step used, so a trace from an unmodified
+// table and estimator replays exactly. Bumps force Stop on the robot, so a
+// record with bump bits set resynchronizes instead.
+// Input: name  trace file from the telemetry UART
+// Output: number of mismatches, -1 if the file can't be read
+static long Replay(const char *name){
+  FILE *f = fopen(name, "rb");
+  uint8_t buf[sizeof(Telemetry_Record_t)];
+  FSM_t fsm;
+  long records = 0, mismatches = 0, skipped = 0;
+  int c, first = 1;
+  if(f == NULL){
+    perror(name);
+    return -1;
+  }
+  FSM_Init(&fsm, L_Center);
+  while((c = fgetc(f)) != EOF){
+    if(c != TELEMETRY_SYNC){
+      skipped++;                // resynchronize on the next sync byte
+      continue;
+    }
+    buf[0] = (uint8_t)c;
+    if(fread(&buf[1], 1, sizeof(buf) - 1, f) != sizeof(buf) - 1){
+      break;
+    }
+    if(buf[1] >= FSM_NUM_STATES){
+      skipped += sizeof(buf);   // not a record boundary
+      continue;
+    }
+    if(first){
+      FSM_Init(&fsm, buf[1]);   // trace may start mid-run
+      first = 0;
+    }else if(buf[3]){
+      if(fsm.state != buf[1]) FSM_Enter(&fsm, buf[1]);
+    }else{
+      FSM_Step(&fsm, buf[2]);
+      if(fsm.state != buf[1]){
+        if(mismatches < 10){
+          printf("  record %ld: raw 0x%02X recorded %s, replayed %s\n",
+                 records, buf[2], StateName[buf[1]], StateName[fsm.state]);
+        }
+        mismatches++;
+        FSM_Enter(&fsm, buf[1]);
+      }
+    }
+    records++;
+  }
+  fclose(f);
+  printf("replay    %s: %ld records, %ld mismatches, %ld bytes skipped\n",
+         name, records, mismatches, skipped);
+  return mismatches;
+}
+
+// ------------Benchmark------------
+// Time FSM_Step() on the host with a walk across the line,
+// and the classifier alone over every possible sample.
+// Input: none
+// Output: none
+static void Benchmark(void){
+  static uint8_t walk[256];
+  FSM_t fsm;
+  volatile uint32_t sink = 0;
+  double start, steps, classify;
+  uint32_t i, n;
+  for(i = 0; i < 256; i++){     // line drifting right to left and back
+    n = (i < 128)? i/16 : (255 - i)/16;
+    walk[i] = (uint8_t)((0x03<<n)&0xFF);
+  }
+  FSM_Init(&fsm, L_Center);
+  start = Seconds();
+  for(i = 0; i < BENCH_STEPS; i++){
+    sink += FSM_Step(&fsm, walk[(i>>4)&0xFF]);
+  }
+  steps = BENCH_STEPS/(Seconds() - start + 1e-9);
+  start = Seconds();
+  for(i = 0; i < BENCH_STEPS; i++){
+    sink += nextStateIDX(Reflectance_Position((uint8_t)i));
+  }
+  classify = BENCH_STEPS/(Seconds() - start + 1e-9);
+  printf("bench     FSM_Step %.1f M/s, position+classify %.1f M/s\n",
+         steps/1e6, classify/1e6);
+}
+
+static void Usage(void){
+  fprintf(stderr,
+    "usage: linesim [-L straight] [-R radius] [-n laps] [-T timeout] [-d dropout] [-s] [-M] [-b] [-r trace.bin]\n"
+    "  -L  length of each straight in mm (default 1000)\n"
+    "  -R  radius of the turns in mm (default 300)\n"
+    "  -n  laps to drive, 1 to 16 (default 3)\n"
+    "  -T  simulated time limit in s (default 60)\n"
+    "  -d  sensor frames lost, per mille (default 0)\n"
+    "  -s  fixed speeds, no curve scheduling\n"
+    "  -M  start/finish marker; learn a lap, then race the map\n"
+    "  -b  skip the benchmark\n"
+    "  -r  replay a telemetry trace instead of driving\n");
+}
+
+int main(int argc, char **argv){
+  Track_t track = {1000.0, 300.0, 0};
+  struct Result res;
+  double start, wall, best = 0.0;
+  int laps = 3, bench = 1, dropout = 0, schedule = 1, map = 0, i;
+  double timeout = 60.0;
+  const char *trace = NULL;
+
+  for(i = 1; i < argc; i++){
+    if(!strcmp(argv[i], "-b")){
+      bench = 0;
+    }else if(!strcmp(argv[i], "-s")){
+      schedule = 0;
+    }else if(!strcmp(argv[i], "-M")){
+      map = 1;
+      track.marker = 1;
+    }else if((i + 1 < argc) && !strcmp(argv[i], "-L")){
+      track.straight = atof(argv[++i]);
+    }else if((i + 1 < argc) && !strcmp(argv[i], "-R")){
+      track.radius = atof(argv[++i]);
+    }else if((i + 1 < argc) && !strcmp(argv[i], "-n")){
+      laps = atoi(argv[++i]);
+    }else if((i + 1 < argc) && !strcmp(argv[i], "-T")){
+      timeout = atof(argv[++i]);
+    }else if((i + 1 < argc) && !strcmp(argv[i], "-d")){
+      dropout = atoi(argv[++i]);
+    }else if((i + 1 < argc) && !strcmp(argv[i], "-r")){
+      trace = argv[++i];
+    }else{
+      Usage();
+      return 2;
+    }
+  }
+  if((laps < 1) || (laps > 16) || (track.radius <= 0.0) || (track.straight < 0.0)){
+    Usage();
+    return 2;
+  }
+  if(trace){
+    long mismatches = Replay(trace);
+    return (mismatches == 0)? 0 : (mismatches < 0)? 2 : 1;
+  }
+
+  printf("table     %d states, near %d, far %d\n", FSM_NUM_STATES, FSM_NEAR, FSM_FAR);
+  printf("track     %.0f mm straights, %.0f mm turns, %.0f mm lap\n",
+         track.straight, track.radius, Track_Length(&track));
+  start = Seconds();
+  Simulate(&track, laps, timeout, dropout, schedule, map, &res);
+  wall = Seconds() - start;
+  for(i = 0; i < res.laps; i++){
+    printf("lap %-5d %.3f s\n", i + 1, res.lap[i]);
+    if((i == 0) || (res.lap[i] < best)) best = res.lap[i];
+  }
+  printf("run       %s after %.3f s, %u transitions, %.1f%% lost, worst %.1f mm off\n",
+         res.derailed? "derailed" : (res.laps < laps)? "timed out" : "finished",
+         res.ticks/1000.0, res.changes, 100.0*res.lost/(res.ticks? res.ticks : 1), res.worst);
+  printf("schedule  %.1f%% straight, %.1f%% braking\n",
+         100.0*res.straight/(res.ticks? res.ticks : 1), 100.0*res.braking/(res.ticks? res.ticks : 1));
+  if(map){
+    printf("map       %u segments, %.1f%% racing\n",
+           res.segments, 100.0*res.racing/(res.ticks? res.ticks : 1));
+  }
+  printf("sim       %.1f k ticks/s (%.0fx real time)\n",
+         res.ticks/(wall + 1e-9)/1e3, res.ticks/1000.0/(wall + 1e-9));
+  if(bench){
+    Benchmark();
+  }
+  // one line for sweep scripts: laps, best lap (s), worst error (mm)
+  printf("result    %d %.3f %.1f\n", res.laps, best, res.worst);
+  return (res.laps == laps)? 0 : 1;
+}
@@ -0,0 +1,105 @@
+// Track.c
+// Runs on the host
+// Kinematic track model for the simulator: stadium geometry,
+// a binary sensor bar and a first-order differential drive.
+// Team Donkey Kong
+
+#include <math.h>
+#include <stdint.h>
+#include "FixedPoint.h"
+#include "Track.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Sensor offsets across the bar, left positive, bit0 first.
+// Same spacing as the Reflectance_Position() weights (um).
+static const double SensorY[8] = {-33.4, -23.8, -14.3, -4.8, 4.8, 14.3, 23.8, 33.4};
+
+double Track_Length(const Track_t *t){
+  return 2.0*t->straight + 2.0*M_PI*t->radius;
+}
+
+// Straights at y = -R (heading +x) and y = +R (heading -x),
+// half circles centered at (+-L/2, 0); the lap runs counter-clockwise.
+double Track_Distance(const Track_t *t, double x, double y){
+  double h = t->straight/2.0, r = t->radius, cx, d, best;
+  cx = (x < -h)? -h : (x > h)? h : x;
+  best = hypot(x - cx, y + r);                 // bottom straight
+  d = hypot(x - cx, y - r);                    // top straight
+  if(d < best) best = d;
+  if(x >= h){
+    d = fabs(hypot(x - h, y) - r);             // right half circle
+    if(d < best) best = d;
+  }
+  if(x <= -h){
+    d = fabs(hypot(x + h, y) - r);             // left half circle
+    if(d < best) best = d;
+  }
+  return best;
+}
+
+// Arc length of the point of the line nearest (x, y), 0 at the start line
+static double ArcLength(const Track_t *t, double x, double y){
+  double h = t->straight/2.0, r = t->radius, a;
+  if(x > h){
+    a = atan2(y, x - h);                       // -pi/2 .. pi/2
+    return t->straight + (a + M_PI/2.0)*r;
+  }
+  if(x < -h){
+    a = atan2(y, x + h);
+    if(a < 0) a += 2.0*M_PI;                   // pi/2 .. 3pi/2
+    return 2.0*t->straight + M_PI*r + (a - M_PI/2.0)*r;
+  }
+  if(y < 0){
+    return x + h;                              // bottom straight
+  }
+  return t->straight + M_PI*r + (h - x);       // top straight
+}
+
+void Track_Start(const Track_t *t, Robot_t *r){
+  r->x = 0.0;
+  r->y = -t->radius;
+  r->heading = 0.0;
+  r->vLeft = r->vRight = 0.0;
+  r->progress = 0.0;
+  r->odometer = 0.0;
+  r->lastS = ArcLength(t, r->x, r->y);
+}
+
+uint8_t Track_Sense(const Track_t *t, const Robot_t *r){
+  double c = cos(r->heading), s = sin(r->heading);
+  double bx = r->x + TRACK_BAR_AHEAD*c, by = r->y + TRACK_BAR_AHEAD*s;
+  uint8_t data = 0;
+  int i;
+  double x, y;
+  for(i = 0; i < 8; i++){
+    x = bx - SensorY[i]*s;
+    y = by + SensorY[i]*c;
+    if(Track_Distance(t, x, y) < TRACK_LINE_HALF){
+      data |= 1<<i;
+    }else if(t->marker && (fabs(x) < TRACK_LINE_HALF) && (fabs(y + t->radius) < TRACK_MARKER_HALF)){
+      data |= 1<<i;             // start/finish bar across the bottom straight
+    }
+  }
+  return data;
+}
+
+void Track_Move(const Track_t *t, Robot_t *r, int32_t left, int32_t right, double dt){
+  double k = dt/TRACK_TAU, v, w, s, ds, length = Track_Length(t);
+  r->vLeft += (TRACK_VMAX*left/FX_DUTY_MAX - r->vLeft)*k;
+  r->vRight += (TRACK_VMAX*right/FX_DUTY_MAX - r->vRight)*k;
+  v = (r->vLeft + r->vRight)/2.0;
+  w = (r->vRight - r->vLeft)/TRACK_WHEELBASE;
+  r->odometer += v*dt;
+  r->x += v*cos(r->heading)*dt;
+  r->y += v*sin(r->heading)*dt;
+  r->heading += w*dt;
+  s = ArcLength(t, r->x, r->y);
+  ds = s - r->lastS;
+  if(ds < -length/2.0) ds += length;           // crossed the start line forward
+  if(ds > length/2.0) ds -= length;            // or backward
+  r->progress += ds;
+  r->lastS = s;
+}
@@ -0,0 +1,86 @@
+/**
+ * @file      Track.h
+ * @brief     Track and robot model for the host simulator
+ * @details   A stadium-shaped track (two straights joined by two half
+ * circles) with a black line on a white floor, and a differential-drive
+ * robot with the RSLK sensor bar. All lengths are in mm, angles in
+ * radians, times in s.
+ * @author    Team Donkey Kong
+ ******************************************************************************/
+
+#ifndef TRACK_H_
+#define TRACK_H_
+#include <stdint.h>
+
+#define TRACK_LINE_HALF   9.5     // half width of the line (19 mm tape)
+#define TRACK_WHEELBASE 140.0     // distance between the wheels
+#define TRACK_BAR_AHEAD  70.0     // sensor bar ahead of the axle
+#define TRACK_VMAX      550.0     // wheel speed at FX_DUTY_MAX (150 rpm, 70 mm wheel)
+#define TRACK_TAU         0.05    // motor time constant
+#define TRACK_MARKER_HALF 75.0    // half length of the start/finish marker
+
+struct Track {
+  double straight;                // length of each straight
+  double radius;                  // radius of each half circle
+  int marker;                     // 1 for a start/finish marker across the line
+};
+typedef struct Track Track_t;
+
+struct Robot {
+  double x, y, heading;           // axle center and heading on the track
+  double vLeft, vRight;           // wheel speeds, mm/s
+  double progress;                // distance along the line, unwrapped
+  double odometer;                // distance the axle center has rolled
+  double lastS;                   // arc length of the last update
+};
+typedef struct Robot Robot_t;
+
+/**
+ * Length of the line around the whole track.
+ * @param  t track
+ * @return lap length in mm
+ * @brief  Lap length
+ */
+double Track_Length(const Track_t *t);
+
+/**
+ * Distance from a point to the line.
+ * @param  t track
+ * @param  x,y point
+ * @return distance to the center of the line in mm
+ * @brief  Distance to the line
+ */
+double Track_Distance(const Track_t *t, double x, double y);
+
+/**
+ * Place the robot on the start line, centered and pointing along it.
+ * The sensor bar is past the marker, so the first lap ends on it.
+ * @param  t track
+ * @param  r robot
+ * @return none
+ * @brief  Reset the robot
+ */
+void Track_Start(const Track_t *t, Robot_t *r);
+
+/**
+ * Read the eight sensors.
+ * @param  t track
+ * @param  r robot
+ * @return 8-bit sample, bit0 on the robot's right, 1 means black
+ * @note   The marker is a TRACK_LINE_HALF wide bar across the start line
+ * @brief  Model the sensor bar
+ */
+uint8_t Track_Sense(const Track_t *t, const Robot_t *r);
+
+/**
+ * Advance the robot by one time step.
+ * @param  t track
+ * @param  r robot
+ * @param  left, right signed wheel duties, -14998 to 14998
+ * @param  dt time step in s
+ * @return none
+ * @brief  Move the robot
+ */
+void Track_Move(const Track_t *t, Robot_t *r, int32_t left, int32_t right, double dt);
+
+#endif /* TRACK_H_ */
@@ -35,6 +35,7 @@
 *****************************************************************************/
 
 #include <stdint.h>
+#include "Boot.h"            /* boot trace, Boot_Mark() in Reset_Handler */
 
 /* Linker variable that marks the top of the stack. */
 extern unsigned long __STACK_END;
@@ -46,6 +47,7 @@ extern void _c_int00(void);
 /* External declaration for system initialization function                  */
 extern void SystemInit(void);
 
+
 /* Forward declaration of the default fault handlers. */
 void Default_Handler            (void) __attribute__((weak));
 extern void Reset_Handler       (void) __attribute__((weak));
@@ -180,7 +182,9 @@ void (* const interruptVectors[])(void) =
 /* application.                                                                */
 void Reset_Handler(void)
 {
+    Boot_Mark(BOOT_RESET);
     SystemInit();
+    Boot_Mark(BOOT_SYSTEMINIT);
 
     /* Jump to the CCS C Initialization Routine. */
     __asm("    .global _c_int00\n"